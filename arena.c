@@ -0,0 +1,89 @@
+#include "arena.h"
+#include <stdlib.h>
+
+
+/*
+ * Initialize empty arena 'a'.
+ * Memory is only allocated by the first allocation.
+ */
+void jctl_arena_init (jctl_arena *a)
+{
+	a->head = NULL;
+}
+
+
+/*
+ * Free all blocks of arena 'a',
+ * and everything allocated from it.
+ */
+void jctl_arena_free (jctl_arena *a)
+{
+	jctl_arena_block *b = a->head;
+	while(b != NULL)
+	{
+		jctl_arena_block *next = b->next;
+		free(b);
+		b = next;
+	}
+	a->head = NULL;
+}
+
+
+/*
+ * Move all blocks of arena 'from' into arena 'a',
+ * leaving 'from' empty.
+ * Allocations go on in the current block of 'a'.
+ */
+void jctl_arena_merge (jctl_arena *a, jctl_arena *from)
+{
+	if(from->head == NULL)
+		return;
+
+	if(a->head == NULL)
+	{
+		a->head = from->head;
+		from->head = NULL;
+		return;
+	}
+
+	jctl_arena_block *tail = from->head;
+	while(tail->next != NULL)
+		tail = tail->next;
+	tail->next = a->head->next;
+	a->head->next = from->head;
+	from->head = NULL;
+}
+
+
+/*
+ * Allocate 'n' bytes of arena 'a', not aligned.
+ * Return NULL if out of memory.
+ */
+void *jctl_arena_alloc (jctl_arena *a, size_t n)
+{
+	jctl_arena_block *b = a->head;
+	if(b == NULL || b->size - b->used < n)
+	{
+		size_t size = (n > JCTL_ARENA_BLOCK - sizeof(*b)) ? n : JCTL_ARENA_BLOCK - sizeof(*b);
+		b = (jctl_arena_block*)malloc(sizeof(*b) + size);
+		if(b == NULL)
+			return NULL;
+		b->size = size;
+		b->used = 0;
+
+		/* an oversized block goes behind the current one, which still has room */
+		if(a->head != NULL && size > JCTL_ARENA_BLOCK - sizeof(*b))
+		{
+			b->next = a->head->next;
+			a->head->next = b;
+			b->used = n;
+			return (char*)(b + 1);
+		}
+		b->next = a->head;
+		a->head = b;
+	}
+
+	void *p = (char*)(b + 1) + b->used;
+	b->used += n;
+	return p;
+}
@@ -0,0 +1,51 @@
+#ifndef JCTL_ARENA_H
+#define JCTL_ARENA_H
+
+#include "jctl.h"
+#include <stddef.h>
+
+
+/*
+ * Size of an arena block,
+ * bigger allocations get a block of their own.
+ */
+#define JCTL_ARENA_BLOCK	(64 * 1024)
+
+
+/*
+*
+* Arena Block
+*
+*/
+typedef struct jctl_arena_block_s
+{
+	struct jctl_arena_block_s *next;	/* block allocated before */
+	size_t size;						/* usable bytes */
+	size_t used;						/* bytes handed out */
+} jctl_arena_block;
+
+
+/*
+*
+* Arena
+*
+* Bump allocator for the many small strings of a run,
+* which all live until the end of it.
+* Nothing is freed by itself, the whole arena is freed at once.
+* Not thread safe, every thread owns its own arena.
+*
+*/
+typedef struct jctl_arena_s
+{
+	jctl_arena_block *head;		/* current block, NULL if none */
+} jctl_arena;
+
+
+void	jctl_arena_init		(jctl_arena *a);
+void	jctl_arena_free		(jctl_arena *a);
+void	jctl_arena_merge	(jctl_arena *a, jctl_arena *from);
+
+void*	jctl_arena_alloc	(jctl_arena *a, size_t n);
+
+
+#endif /* JCTL_ARENA_H */
@@ -0,0 +1,433 @@
+#define _FILE_OFFSET_BITS 64
+
+#include "cache.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+	#include <io.h>
+	#include <direct.h>
+	#include <process.h>
+	#define getpid _getpid
+#else
+	#include <unistd.h>
+#endif
+
+#if defined(__unix__) || (defined(__APPLE__) && defined(__MACH__))
+	#define JCTL_CACHE_MMAP
+	#include <sys/mman.h>
+#endif
+
+#ifndef O_BINARY
+	#define O_BINARY (0)
+#endif
+
+
+static const char jctl_cache_magic[8] = "JCTLIDX";
+
+
+/*
+ * Return the hash of device 'dev' and inode 'ino'.
+ */
+static uint64_t jctl_cache_hash (uint64_t dev, uint64_t ino)
+{
+	uint64_t h = ino ^ (dev * 0x9E3779B97F4A7C15ULL);
+	h ^= h >> 33;
+	h *= 0xFF51AFD7ED558CCDULL;
+	h ^= h >> 33;
+	h *= 0xC4CEB9FE1A85EC53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+
+/*
+ * Return the slot of device 'dev' and inode 'ino'
+ * in the table 'slots' of 'cap' slots,
+ * or the empty slot it would go into.
+ * Return NULL if neither is found (the table is full).
+ */
+static jctl_cache_slot *jctl_cache_probe (jctl_cache_slot *slots, uint64_t cap, uint64_t dev, uint64_t ino)
+{
+	uint64_t mask = cap - 1;
+	uint64_t i = jctl_cache_hash(dev, ino) & mask;
+
+	for(uint64_t n = 0; n < cap; ++n, i = (i + 1) & mask)
+	{
+		jctl_cache_slot *s = slots + i;
+		if(s->ino == 0 || (s->ino == ino && s->dev == dev))
+			return s;
+	}
+
+	return NULL;
+}
+
+
+/*
+ * Create directory 'path' if it doesn't exist yet.
+ */
+static void jctl_cache_mkdir (const char *path)
+{
+#ifdef _WIN32
+	_mkdir(path);
+#else
+	mkdir(path, 0700);
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * Return the name of the cache file, malloc'ed,
+ * "$XDG_CACHE_HOME/jctl/index" or by default "~/.cache/jctl/index".
+ * Creates the directories on the way.
+ * Return NULL if there is no home directory (or out of memory).
+ */
+static char *jctl_cache_path (void)
+{
+	const char *base = getenv("XDG_CACHE_HOME");
+	const char *sub = "";
+
+	/* relative paths are invalid by the XDG specification */
+	if(base == NULL || base[0] != '/')
+	{
+		base = getenv("HOME");
+		sub = "/.cache";
+#ifdef _WIN32
+		if(base == NULL)
+		{
+			base = getenv("LOCALAPPDATA");
+			sub = "";
+		}
+#endif /* defined(_WIN32) */
+	}
+
+	if(base == NULL || base[0] == '\0')
+		return NULL;
+
+	size_t len = strlen(base) + strlen(sub) + sizeof("/jctl/index");
+	char *fn = (char*)malloc(len);
+	if(fn == NULL)
+		return NULL;
+
+	snprintf(fn, len, "%s%s", base, sub);
+	jctl_cache_mkdir(fn);
+	strcat(fn, "/jctl");
+	jctl_cache_mkdir(fn);
+	strcat(fn, "/index");
+
+	return fn;
+}
+
+
+/*
+ * Map the cache file of cache 'c' into memory.
+ * A missing, foreign or damaged file leaves the cache empty.
+ */
+static void jctl_cache_load (jctl_cache *c)
+{
+	int fd = open(c->fn, O_RDONLY | O_BINARY);
+	if(fd < 0)
+		return;
+
+	struct stat st;
+	if(fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(jctl_cache_header) || (uintmax_t) st.st_size > SIZE_MAX)
+	{
+		close(fd);
+		return;
+	}
+
+	size_t size = (size_t) st.st_size;
+
+#ifdef JCTL_CACHE_MMAP
+	/*
+	 * Caches are replaced by renaming a new file over them,
+	 * never written in place, so the mapping stays valid.
+	 */
+	void *p = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if(p == MAP_FAILED)
+		p = NULL;
+#else
+	void *p = malloc(size);
+	for(size_t off = 0; p != NULL && off < size;)
+	{
+		int n = read(fd, (char*) p + off, (unsigned int)(size - off));
+		if(n <= 0)
+		{
+			free(p);
+			p = NULL;
+		}
+		else
+			off += n;
+	}
+#endif /* defined(JCTL_CACHE_MMAP) */
+
+	close(fd);
+	if(p == NULL)
+		return;
+
+	c->map = p;
+	c->mapsize = size;
+
+	jctl_cache_header *h = (jctl_cache_header*) p;
+	uint64_t cap = (size - sizeof(*h)) / sizeof(jctl_cache_slot);
+
+	if(memcmp(h->magic, jctl_cache_magic, sizeof(h->magic)) != 0
+	|| h->version != JCTL_CACHE_VERSION
+	|| h->slotsize != sizeof(jctl_cache_slot)
+	|| h->cap == 0 || (h->cap & (h->cap - 1)) != 0 || h->cap != cap)
+		return;
+
+	c->h = h;
+	c->slots = (jctl_cache_slot*)(h + 1);
+}
+
+
+/*
+ * Open the line count cache.
+ * Return the cache, or NULL if there's
+ * no place for it (or out of memory).
+ */
+jctl_cache *jctl_cache_open (void)
+{
+	jctl_cache *c = (jctl_cache*)calloc(1, sizeof(*c));
+	if(c == NULL)
+		return NULL;
+
+	c->start = time(NULL);
+	c->fn = jctl_cache_path();
+	if(c->fn == NULL)
+	{
+		free(c);
+		return NULL;
+	}
+
+	jctl_cache_load(c);
+	return c;
+}
+
+
+/*
+ * Free cache 'c'.
+ */
+void jctl_cache_free (jctl_cache *c)
+{
+	if(c == NULL)
+		return;
+
+#ifdef JCTL_CACHE_MMAP
+	if(c->map != NULL)
+		munmap(c->map, c->mapsize);
+#else
+	free(c->map);
+#endif /* defined(JCTL_CACHE_MMAP) */
+
+	free(c->puts);
+	free(c->fn);
+	free(c);
+}
+
+
+/*
+ * Look up the line count of the file of information 'fi' in cache 'c'.
+ * Return 1 and set 'lc' if the file is cached and its size
+ * and modification time are unchanged, otherwise return 0.
+ *
+ * If the file changed but grew past the tail of its cached count,
+ * 't' gets that tail for 'jctl_file_linecount_at' to go on from,
+ * otherwise 't->size' is set to 0.
+ */
+jctl_uint jctl_cache_lookup (jctl_cache *c, jctl_file_info *fi, jctl_size *lc, jctl_file_tail *t)
+{
+	t->size = 0;
+
+	if(c->h == NULL || !fi->reg || fi->ino == 0)
+		return 0;
+
+	jctl_cache_slot *s = jctl_cache_probe(c->slots, c->h->cap, fi->dev, fi->ino);
+	if(s == NULL || s->ino == 0)
+		return 0;
+
+	if(s->size == fi->size && s->mtime == fi->mtime && s->mtimens == fi->mtimens)
+	{
+		*lc = s->lc;
+		return 1;
+	}
+
+	/*
+	 * A file of the same size got rewritten rather than
+	 * appended to, only a grown file is worth checking.
+	 */
+	if(s->tailsize > 0 && fi->size > s->tailsize)
+	{
+		t->size = s->tailsize;
+		t->lc = s->lc - 1;
+		t->pend = (int) s->tailpend;
+		t->sum = s->tailsum;
+	}
+
+	return 0;
+}
+
+
+/*
+ * Add the line count 'lc' and tail 't' (may be NULL)
+ * of the file of information 'fi' to the entries
+ * 'jctl_cache_save' writes to cache 'c'.
+ * Files without an inode are left out,
+ * racily clean files are only kept by their tail.
+ */
+void jctl_cache_put (jctl_cache *c, jctl_file_info *fi, jctl_size lc, jctl_file_tail *t)
+{
+	if(!fi->reg || fi->ino == 0)
+		return;
+
+	int tail = (t != NULL && t->size > 0);
+	int racy = (fi->mtime >= (long long) c->start - JCTL_CACHE_RACY);
+	if(racy && !tail)
+		return;
+
+	if(c->puttop == c->putcap)
+	{
+		size_t cap = c->putcap ? c->putcap * 2 : 256;
+		jctl_cache_slot *puts = (jctl_cache_slot*)realloc(c->puts, sizeof(*puts) * cap);
+		/* the file just doesn't get cached */
+		if(puts == NULL)
+			return;
+		c->puts = puts;
+		c->putcap = cap;
+	}
+
+	jctl_cache_slot *s = c->puts + c->puttop++;
+	s->dev = fi->dev;
+	s->ino = fi->ino;
+	s->size = fi->size;
+	s->mtime = fi->mtime;
+	s->mtimens = racy ? -1 : fi->mtimens;
+	s->lc = lc;
+	s->tailsize = tail ? t->size : 0;
+	s->tailsum = tail ? t->sum : 0;
+	s->tailpend = tail ? t->pend : 0;
+}
+
+
+/*
+ * Write 'size' bytes of 'p' to file 'fd'.
+ * Return 0 on success, otherwise return 1.
+ */
+static int jctl_cache_write (int fd, const char *p, size_t size)
+{
+	while(size > 0)
+	{
+		long long n = write(fd, p, (unsigned int)(size > (1 << 30) ? (1 << 30) : size));
+		if(n < 0 && errno == EINTR)
+			continue;
+		if(n <= 0)
+			return 1;
+		p += n;
+		size -= (size_t) n;
+	}
+	return 0;
+}
+
+
+/*
+ * Write the entries put into cache 'c' together with
+ * the entries of the cache file into a new cache file,
+ * which then replaces the old one.
+ * Nothing is written if nothing was put.
+ *
+ * Return 0 if the cache got saved,
+ * otherwise return 1.
+ */
+jctl_uint jctl_cache_save (jctl_cache *c)
+{
+	if(c->puttop == 0)
+		return 0;
+
+	uint64_t old = (c->h != NULL) ? c->h->count : 0;
+	if(old + c->puttop > JCTL_CACHE_MAX_ENTRIES)
+		old = 0;
+
+	/*
+	 * Keep the table at most half full,
+	 * so probe sequences stay short.
+	 */
+	uint64_t cap = 64;
+	while(cap < (old + c->puttop) * 2)
+		cap *= 2;
+
+	size_t size = sizeof(jctl_cache_header) + cap * sizeof(jctl_cache_slot);
+	char *p = (char*)calloc(1, size);
+	if(p == NULL)
+		return 1;
+
+	jctl_cache_header *h = (jctl_cache_header*) p;
+	jctl_cache_slot *slots = (jctl_cache_slot*)(h + 1);
+	memcpy(h->magic, jctl_cache_magic, sizeof(h->magic));
+	h->version = JCTL_CACHE_VERSION;
+	h->slotsize = sizeof(jctl_cache_slot);
+	h->cap = cap;
+	h->count = 0;
+
+	for(size_t i = 0; i < c->puttop; ++i)
+	{
+		jctl_cache_slot *s = jctl_cache_probe(slots, cap, c->puts[i].dev, c->puts[i].ino);
+		h->count += (s->ino == 0);
+		*s = c->puts[i];
+	}
+
+	/*
+	 * Carry over the old entries
+	 * that weren't counted again.
+	 */
+	for(uint64_t i = 0; old > 0 && i < c->h->cap; ++i)
+	{
+		jctl_cache_slot *o = c->slots + i;
+		if(o->ino == 0)
+			continue;
+		jctl_cache_slot *s = jctl_cache_probe(slots, cap, o->dev, o->ino);
+		if(s == NULL || s->ino != 0)
+			continue;
+		*s = *o;
+		++h->count;
+	}
+
+	/*
+	 * Write a temporary file and rename it over the cache,
+	 * so other runs see either the old or the new cache.
+	 */
+	size_t len = strlen(c->fn) + 32;
+	char *tmp = (char*)malloc(len);
+	if(tmp == NULL)
+	{
+		free(p);
+		return 1;
+	}
+	snprintf(tmp, len, "%s.%ld", c->fn, (long) getpid());
+
+	int err = 1;
+	int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0644);
+	if(fd >= 0)
+	{
+		err = jctl_cache_write(fd, p, size);
+		err |= (close(fd) != 0);
+
+#ifdef _WIN32
+		/* rename doesn't replace files on Windows */
+		if(!err)
+			remove(c->fn);
+#endif /* defined(_WIN32) */
+
+		if(!err)
+			err = (rename(tmp, c->fn) != 0);
+		if(err)
+			remove(tmp);
+	}
+
+	free(tmp);
+	free(p);
+	return err;
+}
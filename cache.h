@@ -0,0 +1,104 @@
+#ifndef JCTL_CACHE_H
+#define JCTL_CACHE_H
+
+#include "jctl.h"
+#include "file.h"
+#include <stdint.h>
+#include <time.h>
+
+
+/*
+ * Cache file format version,
+ * caches of any other version are ignored.
+ */
+#define JCTL_CACHE_VERSION		(2)
+
+/*
+ * Files modified less than JCTL_CACHE_RACY seconds
+ * before the run started are never taken from the cache as they are,
+ * they may still be changing without their
+ * size or modification time telling.
+ * Only their tail is kept, for counting what gets appended.
+ */
+#define JCTL_CACHE_RACY			(2)
+
+/*
+ * Entries of earlier runs are only carried over
+ * while the cache holds less than JCTL_CACHE_MAX_ENTRIES.
+ */
+#define JCTL_CACHE_MAX_ENTRIES	(4 * 1024 * 1024)
+
+
+/*
+*
+* Cache Header
+*
+*/
+typedef struct jctl_cache_header_s
+{
+	char magic[8];			/* "JCTLIDX" */
+	uint32_t version;		/* JCTL_CACHE_VERSION */
+	uint32_t slotsize;		/* size of a slot, catches foreign layouts */
+	uint64_t cap;			/* slot count, a power of two */
+	uint64_t count;			/* used slots */
+} jctl_cache_header;
+
+
+/*
+*
+* Cache Slot
+*
+* An open addressing hash table slot keyed by
+* device and inode, empty if the inode is 0.
+* A slot of a racily clean file has 'mtimens' set to -1,
+* so it never matches the file as it is.
+*
+*/
+typedef struct jctl_cache_slot_s
+{
+	uint64_t dev;			/* device */
+	uint64_t ino;			/* inode */
+	uint64_t size;			/* size in bytes */
+	int64_t mtime;			/* modification time, seconds */
+	int64_t mtimens;		/* modification time, nanoseconds */
+	uint64_t lc;			/* line count */
+	uint64_t tailsize;		/* bytes counted, 0 if unknown */
+	uint64_t tailsum;		/* checksum of the last bytes counted */
+	int64_t tailpend;		/* line break waiting for its pair */
+} jctl_cache_slot;
+
+
+/*
+*
+* Cache
+*
+* The cache file is mapped into memory as it is,
+* lookups probe the mapped table directly.
+* Newly counted files are collected by 'jctl_cache_put'
+* and written together with the old entries into a new file
+* by 'jctl_cache_save', which replaces the old one at once.
+*
+*/
+typedef struct jctl_cache_s
+{
+	char *fn;					/* cache file name */
+	void *map;					/* mapped cache file */
+	size_t mapsize;				/* mapped size */
+	jctl_cache_header *h;		/* header, NULL if empty */
+	jctl_cache_slot *slots;		/* mapped slots */
+	time_t start;				/* time the run started */
+	jctl_cache_slot *puts;		/* newly counted files */
+	size_t puttop;				/* newly counted file count */
+	size_t putcap;				/* newly counted file capacity */
+} jctl_cache;
+
+
+jctl_cache*	jctl_cache_open		(void);
+void		jctl_cache_free		(jctl_cache *c);
+
+jctl_uint	jctl_cache_lookup	(jctl_cache *c, jctl_file_info *fi, jctl_size *lc, jctl_file_tail *t);
+void		jctl_cache_put		(jctl_cache *c, jctl_file_info *fi, jctl_size lc, jctl_file_tail *t);
+jctl_uint	jctl_cache_save		(jctl_cache *c);
+
+
+#endif /* JCTL_CACHE_H */
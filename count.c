@@ -0,0 +1,230 @@
+#include "count.h"
+#include <stdint.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	#define JCTL_COUNT_X86
+	#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__)
+	#define jctl_count_popcount(x) ((jctl_uint) __builtin_popcountll(x))
+#else
+static jctl_uint jctl_count_popcount (uint64_t x)
+{
+	x = x - ((x >> 1) & 0x5555555555555555ULL);
+	x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+	x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	return (jctl_uint) ((x * 0x0101010101010101ULL) >> 56);
+}
+#endif
+
+#define JCTL_COUNT_EVEN	(0x5555555555555555ULL)
+#define JCTL_COUNT_ODD	(0xAAAAAAAAAAAAAAAAULL)
+
+
+/*
+ * Line break rules
+ * ----------------
+ *
+ * A CR or LF starts a line break and takes the byte
+ * right after it as its pair:
+ * - the same byte again (LF LF, CR CR) is another line break,
+ * - the other one (CR LF, LF CR) belongs to the same line break,
+ * - anything else ends the pair without counting.
+ *
+ * A byte taken as a pair never starts a line break itself,
+ * so in a run of line break bytes the starters are the bytes
+ * at an even offset from the start of the run.
+ * The vectorized kernels find these starters 64 bytes at a time
+ * using the same even/odd run trick used by JSON parsers
+ * for finding escaped characters.
+ */
+
+
+static void jctl_count_block_scalar (jctl_count *c, const char *p, size_t n);
+static void (*jctl_count_block_fn) (jctl_count *c, const char *p, size_t n) = jctl_count_block_scalar;
+
+
+/*
+ * Count line breaks in block 'p' of size 'n' one byte at a time.
+ * Used as the fallback kernel and for the tails of the vectorized ones.
+ */
+static void jctl_count_block_scalar (jctl_count *c, const char *p, size_t n)
+{
+	jctl_size lc = c->lc;
+	int pend = c->pend;
+
+	for(const char *e = p + n; p < e; ++p)
+	{
+		char ch = *p;
+		if(pend)
+		{
+			lc += (ch == pend);
+			pend = 0;
+		}
+		else if((ch == '\n') || (ch == '\r'))
+		{
+			++lc;
+			pend = ch;
+		}
+	}
+
+	c->lc = lc;
+	c->pend = pend;
+}
+
+
+#ifdef JCTL_COUNT_X86
+/*
+ * Count line breaks in a 64 byte block given
+ * the masks of its CR bytes 'cr' and LF bytes 'lf'.
+ * Bit 'i' of a mask stands for byte 'i' of the block.
+ */
+static inline void jctl_count_mask (jctl_count *c, uint64_t cr, uint64_t lf)
+{
+	uint64_t nl = cr | lf;
+	uint64_t paired = (c->pend != 0);
+
+	if((nl | paired) == 0)
+		return;
+
+	/*
+	 * Line break bytes that can start a line break,
+	 * the first byte may already be taken as the pair
+	 * of a line break from the previous block.
+	 */
+	uint64_t run = nl & ~paired;
+	uint64_t runstart = run & ~(run << 1);
+
+	/*
+	 * Adding the starting bit to a run
+	 * carries through the whole run and clears it,
+	 * which separates runs starting on even bits
+	 * from runs starting on odd bits.
+	 */
+	uint64_t evenrun = run & ~(run + (runstart & JCTL_COUNT_EVEN));
+	uint64_t oddrun = run & ~evenrun;
+
+	uint64_t starter = (evenrun & JCTL_COUNT_EVEN) | (oddrun & JCTL_COUNT_ODD);
+	uint64_t pair = (starter << 1) | paired;
+	uint64_t same = (cr & ((cr << 1) | (c->pend == '\r')))
+				  | (lf & ((lf << 1) | (c->pend == '\n')));
+
+	c->lc += jctl_count_popcount(starter) + jctl_count_popcount(pair & same);
+
+	if(starter >> 63)
+		c->pend = (cr >> 63) ? '\r' : '\n';
+	else
+		c->pend = 0;
+}
+
+
+/*
+ * SSE2 kernel, four 16 byte compares per 64 byte block.
+ */
+__attribute__((target("sse2")))
+static void jctl_count_block_sse2 (jctl_count *c, const char *p, size_t n)
+{
+	const __m128i vcr = _mm_set1_epi8('\r');
+	const __m128i vlf = _mm_set1_epi8('\n');
+
+	for(; n >= 64; p += 64, n -= 64)
+	{
+		uint64_t cr = 0;
+		uint64_t lf = 0;
+		for(int i = 0; i < 4; ++i)
+		{
+			__m128i v = _mm_loadu_si128((const __m128i*)(p + i * 16));
+			cr |= (uint64_t)(uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(v, vcr)) << (i * 16);
+			lf |= (uint64_t)(uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(v, vlf)) << (i * 16);
+		}
+		jctl_count_mask(c, cr, lf);
+	}
+
+	jctl_count_block_scalar(c, p, n);
+}
+
+
+/*
+ * AVX2 kernel, two 32 byte compares per 64 byte block.
+ */
+__attribute__((target("avx2,popcnt")))
+static void jctl_count_block_avx2 (jctl_count *c, const char *p, size_t n)
+{
+	const __m256i vcr = _mm256_set1_epi8('\r');
+	const __m256i vlf = _mm256_set1_epi8('\n');
+
+	for(; n >= 64; p += 64, n -= 64)
+	{
+		__m256i lo = _mm256_loadu_si256((const __m256i*) p);
+		__m256i hi = _mm256_loadu_si256((const __m256i*)(p + 32));
+		uint64_t cr = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, vcr))
+					| (uint64_t)(uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, vcr)) << 32;
+		uint64_t lf = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, vlf))
+					| (uint64_t)(uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, vlf)) << 32;
+		jctl_count_mask(c, cr, lf);
+	}
+
+	jctl_count_block_scalar(c, p, n);
+}
+
+
+/*
+ * AVX-512 kernel, one 64 byte compare per block
+ * straight into a 64 bit mask register.
+ */
+__attribute__((target("avx512f,avx512bw,popcnt")))
+static void jctl_count_block_avx512 (jctl_count *c, const char *p, size_t n)
+{
+	const __m512i vcr = _mm512_set1_epi8('\r');
+	const __m512i vlf = _mm512_set1_epi8('\n');
+
+	for(; n >= 64; p += 64, n -= 64)
+	{
+		__m512i v = _mm512_loadu_si512((const void*) p);
+		jctl_count_mask(c, _mm512_cmpeq_epi8_mask(v, vcr), _mm512_cmpeq_epi8_mask(v, vlf));
+	}
+
+	jctl_count_block_scalar(c, p, n);
+}
+#endif /* defined(JCTL_COUNT_X86) */
+
+
+/*
+ * Select the fastest kernel the CPU supports.
+ * Must be called once at startup, before any counting.
+ */
+void jctl_count_setup (void)
+{
+#ifdef JCTL_COUNT_X86
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx512bw"))
+		jctl_count_block_fn = jctl_count_block_avx512;
+	else if(__builtin_cpu_supports("avx2"))
+		jctl_count_block_fn = jctl_count_block_avx2;
+	else if(__builtin_cpu_supports("sse2"))
+		jctl_count_block_fn = jctl_count_block_sse2;
+#endif /* defined(JCTL_COUNT_X86) */
+}
+
+
+/*
+ * Initialize the line count state 'c'
+ * for the start of a file.
+ */
+void jctl_count_init (jctl_count *c)
+{
+	c->lc = 0;
+	c->pend = 0;
+}
+
+
+/*
+ * Count the line breaks in block 'p' of size 'n'.
+ * Consecutive blocks of the same file
+ * have to be passed in order with the same state 'c'.
+ */
+void jctl_count_block (jctl_count *c, const char *p, size_t n)
+{
+	jctl_count_block_fn(c, p, n);
+}
@@ -0,0 +1,30 @@
+#ifndef JCTL_COUNT_H
+#define JCTL_COUNT_H
+
+#include "jctl.h"
+#include <stddef.h>
+
+
+/*
+*
+* Line Count State
+*
+* Carried from one block of a file to the next,
+* so that a line break pair split across two
+* blocks is still counted only once.
+*
+*/
+typedef struct jctl_count_s
+{
+	jctl_size lc;	/* line breaks counted so far */
+	int pend;		/* line break waiting for its pair, 0 if none */
+} jctl_count;
+
+
+void		jctl_count_setup	(void);
+
+void		jctl_count_init		(jctl_count *c);
+void		jctl_count_block	(jctl_count *c, const char *p, size_t n);
+
+
+#endif /* JCTL_COUNT_H */
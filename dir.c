@@ -0,0 +1,227 @@
+#include "dir.h"
+#include <string.h>
+#include <errno.h>
+
+#ifdef JCTL_DIR_GETDENTS
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/stat.h>
+	#include <dirent.h>
+	#include <sys/syscall.h>
+#endif
+
+
+/*
+ * Check if 'name' is "." or "..".
+ */
+static int jctl_dir_dots (const char *name)
+{
+	return name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'));
+}
+
+
+#ifdef JCTL_DIR_GETDENTS
+/*
+ * Raw dirent as filled by getdents64.
+ */
+typedef struct jctl_dir_dirent_s
+{
+	unsigned long long d_ino;
+	long long d_off;
+	unsigned short d_reclen;
+	unsigned char d_type;
+	char d_name[];
+} jctl_dir_dirent;
+
+
+/*
+ * Open directory 'path' into 'd'.
+ * Return 0 on success, otherwise return 1.
+ */
+jctl_uint jctl_dir_open (jctl_dir *d, char *path)
+{
+	d->buf = (char*)malloc(JCTL_DIR_BUFSIZE);
+	if(d->buf == NULL)
+		return 1;
+
+	do d->fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	while(d->fd < 0 && errno == EINTR);
+
+	if(d->fd < 0)
+	{
+		free(d->buf);
+		return 1;
+	}
+
+	d->pos = 0;
+	d->len = 0;
+	return 0;
+}
+
+
+/*
+ * Read the next entry of directory 'd' into 'e',
+ * skipping "." and "..".
+ * Most filesystems tell the type of an entry,
+ * only those that don't cost a stat.
+ * Return 1 if there was one, otherwise return 0.
+ */
+jctl_uint jctl_dir_read (jctl_dir *d, jctl_dir_entry *e)
+{
+	for(;;)
+	{
+		if(d->pos >= d->len)
+		{
+			long n = syscall(SYS_getdents64, d->fd, d->buf, JCTL_DIR_BUFSIZE);
+			if(n < 0 && errno == EINTR)
+				continue;
+			if(n <= 0)
+				return 0;
+			d->pos = 0;
+			d->len = (size_t) n;
+		}
+
+		jctl_dir_dirent *de = (jctl_dir_dirent*)(d->buf + d->pos);
+		d->pos += de->d_reclen;
+
+		if(jctl_dir_dots(de->d_name))
+			continue;
+
+		unsigned char type = de->d_type;
+		if(type == DT_UNKNOWN)
+		{
+			struct stat st;
+			if(fstatat(d->fd, de->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+				continue;
+			type = S_ISREG(st.st_mode) ? DT_REG : S_ISDIR(st.st_mode) ? DT_DIR : DT_LNK;
+		}
+
+		e->name = de->d_name;
+		e->namelen = (jctl_uint) strlen(de->d_name);
+		e->type = (type == DT_REG) ? JCTL_DIR_TYPE_REG : (type == DT_DIR) ? JCTL_DIR_TYPE_DIR : JCTL_DIR_TYPE_OTHER;
+		e->ino = de->d_ino;
+		return 1;
+	}
+}
+
+
+/*
+ * Close directory 'd'.
+ */
+void jctl_dir_close (jctl_dir *d)
+{
+	if(d->fd >= 0)
+		close(d->fd);
+	free(d->buf);
+}
+
+
+/*
+ * Return the device directory 'd' resides on,
+ * that of all its files but mount points, 0 if unknown.
+ */
+jctl_size jctl_dir_dev (jctl_dir *d)
+{
+	struct stat st;
+	if(fstat(d->fd, &st) != 0)
+		return 0;
+	return (jctl_size) st.st_dev;
+}
+
+
+/*
+ * Return the file descriptor of directory 'd',
+ * for opening its files with 'jctl_file_linecount_at'.
+ */
+int jctl_dir_fd (jctl_dir *d)
+{
+	return d->fd;
+}
+
+
+/*
+ * Take the file descriptor of directory 'd',
+ * so it stays open after 'jctl_dir_close'.
+ * Nothing can be read from 'd' afterwards.
+ */
+int jctl_dir_detach (jctl_dir *d)
+{
+	int fd = d->fd;
+	d->fd = -1;
+	d->pos = d->len = 0;
+	return fd;
+}
+
+
+/*
+ * Close directory file descriptor 'fd' taken by 'jctl_dir_detach'.
+ */
+void jctl_dir_fd_close (int fd)
+{
+	close(fd);
+}
+
+
+#else /* !defined(JCTL_DIR_GETDENTS) */
+
+
+jctl_uint jctl_dir_open (jctl_dir *d, char *path)
+{
+	return (tinydir_open(&d->dir, path) == -1);
+}
+
+
+jctl_uint jctl_dir_read (jctl_dir *d, jctl_dir_entry *e)
+{
+	for(; d->dir.has_next; tinydir_next(&d->dir))
+	{
+		if(tinydir_readfile(&d->dir, &d->file) == -1 || jctl_dir_dots(d->file.name))
+			continue;
+
+		e->name = d->file.name;
+		e->namelen = (jctl_uint) strlen(d->file.name);
+		e->type = d->file.is_reg ? JCTL_DIR_TYPE_REG : d->file.is_dir ? JCTL_DIR_TYPE_DIR : JCTL_DIR_TYPE_OTHER;
+		e->ino = (jctl_size) d->file._s.st_ino;
+
+		tinydir_next(&d->dir);
+		return 1;
+	}
+	return 0;
+}
+
+
+void jctl_dir_close (jctl_dir *d)
+{
+	tinydir_close(&d->dir);
+}
+
+
+jctl_size jctl_dir_dev (jctl_dir *d)
+{
+	struct stat st;
+	if(stat(d->dir.path, &st) != 0)
+		return 0;
+	return (jctl_size) st.st_dev;
+}
+
+
+/* tinydir has no file descriptor to open files relative to */
+int jctl_dir_fd (jctl_dir *d)
+{
+	return -1;
+}
+
+
+int jctl_dir_detach (jctl_dir *d)
+{
+	return -1;
+}
+
+
+void jctl_dir_fd_close (int fd)
+{
+}
+
+
+#endif /* defined(JCTL_DIR_GETDENTS) */
+
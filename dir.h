@@ -0,0 +1,81 @@
+#ifndef JCTL_DIR_H
+#define JCTL_DIR_H
+
+#include "jctl.h"
+
+/*
+ * Linux directories are read as raw dirents,
+ * other systems go through tinydir.
+ */
+#ifdef __linux__
+	#define JCTL_DIR_GETDENTS
+#else
+	#include "tinydir.h"
+#endif
+
+
+/*
+ * Size of the buffer raw dirents are read into at once.
+ */
+#define JCTL_DIR_BUFSIZE	(64 * 1024)
+
+
+/*
+*
+* Directory Entry Type
+*
+*/
+typedef enum jctl_dir_type_e
+{
+	JCTL_DIR_TYPE_REG,		/* regular file */
+	JCTL_DIR_TYPE_DIR,		/* directory */
+	JCTL_DIR_TYPE_OTHER		/* symbolic link, pipe, device, ... */
+} jctl_dir_type;
+
+
+/*
+*
+* Directory Entry
+*
+* Valid until the next entry is read.
+*
+*/
+typedef struct jctl_dir_entry_s
+{
+	char *name;				/* filename */
+	jctl_uint namelen;		/* filename length */
+	jctl_dir_type type;		/* type, symbolic links aren't followed */
+	jctl_size ino;			/* inode, 0 if unknown */
+} jctl_dir_entry;
+
+
+/*
+*
+* Directory
+*
+*/
+typedef struct jctl_dir_s
+{
+#ifdef JCTL_DIR_GETDENTS
+	int fd;					/* directory file descriptor */
+	char *buf;				/* dirent buffer */
+	size_t pos;				/* next dirent in the buffer */
+	size_t len;				/* dirent bytes in the buffer */
+#else
+	tinydir_dir dir;		/* tinydir directory */
+	tinydir_file file;		/* last file read */
+#endif /* defined(JCTL_DIR_GETDENTS) */
+} jctl_dir;
+
+
+jctl_uint	jctl_dir_open		(jctl_dir *d, char *path);
+jctl_uint	jctl_dir_read		(jctl_dir *d, jctl_dir_entry *e);
+void		jctl_dir_close		(jctl_dir *d);
+
+jctl_size	jctl_dir_dev		(jctl_dir *d);
+int			jctl_dir_fd			(jctl_dir *d);
+int			jctl_dir_detach		(jctl_dir *d);
+void		jctl_dir_fd_close	(int fd);
+
+
+#endif /* JCTL_DIR_H */
@@ -0,0 +1,255 @@
+#include "emit.h"
+#include <string.h>
+
+
+/*
+ * Store 'v' as 32 bit little endian number at 'p'.
+ */
+static inline void jctl_emit_le32 (unsigned char *p, uint32_t v)
+{
+	for(jctl_uint i = 0; i < 4; ++i)
+		p[i] = (unsigned char)(v >> (i * 8));
+}
+
+
+/*
+ * Store 'v' as 64 bit little endian number at 'p'.
+ */
+static inline void jctl_emit_le64 (unsigned char *p, uint64_t v)
+{
+	for(jctl_uint i = 0; i < 8; ++i)
+		p[i] = (unsigned char)(v >> (i * 8));
+}
+
+
+/*
+ * Return the length of the well-formed UTF-8 sequence
+ * at the start of the 'n' bytes of 's' (at least one,
+ * starting past ASCII), or 0 if there is none.
+ * Overlong forms and surrogates are not well-formed.
+ */
+static size_t jctl_emit_utf8_len (const unsigned char *s, size_t n)
+{
+	unsigned char c = s[0];
+	size_t len;
+	unsigned char lo = 0x80, hi = 0xBF;
+
+	if(c >= 0xC2 && c <= 0xDF)
+		len = 2;
+	else if(c >= 0xE0 && c <= 0xEF)
+	{
+		len = 3;
+		if(c == 0xE0)
+			lo = 0xA0;
+		else if(c == 0xED)
+			hi = 0x9F;
+	}
+	else if(c >= 0xF0 && c <= 0xF4)
+	{
+		len = 4;
+		if(c == 0xF0)
+			lo = 0x90;
+		else if(c == 0xF4)
+			hi = 0x8F;
+	}
+	else
+		return 0;
+
+	if(n < len || s[1] < lo || s[1] > hi)
+		return 0;
+	for(size_t i = 2; i < len; ++i)
+		if(s[i] < 0x80 || s[i] > 0xBF)
+			return 0;
+	return len;
+}
+
+
+/*
+ * Add the 'n' bytes of string 's' as JSON string to the output of writer 'o'.
+ * Runs of bytes that need no escape are written as they are,
+ * UTF-8 sequences too. JSON text has to be UTF-8, so every byte
+ * of a path that isn't is replaced by U+FFFD.
+ */
+static void jctl_emit_json_string (jctl_out *o, const char *s, size_t n)
+{
+	static const char hex[] = "0123456789abcdef";
+	size_t run = 0;
+
+	jctl_out_write(o, "\"", 1);
+	for(size_t i = 0; i < n; ++i)
+	{
+		unsigned char c = (unsigned char) s[i];
+		if(c >= 0x20 && c < 0x80 && c != '"' && c != '\\')
+			continue;
+
+		size_t len = (c >= 0x80) ? jctl_emit_utf8_len((const unsigned char*) s + i, n - i) : 0;
+		if(len > 0)
+		{
+			i += len - 1;
+			continue;
+		}
+
+		jctl_out_write(o, s + run, i - run);
+		run = i + 1;
+
+		if(c >= 0x80)
+		{
+			jctl_out_write(o, "\\ufffd", 6);
+			continue;
+		}
+
+		switch(c)
+		{
+		case '"':	jctl_out_write(o, "\\\"", 2); break;
+		case '\\':	jctl_out_write(o, "\\\\", 2); break;
+		case '\n':	jctl_out_write(o, "\\n", 2); break;
+		case '\r':	jctl_out_write(o, "\\r", 2); break;
+		case '\t':	jctl_out_write(o, "\\t", 2); break;
+		default:
+		{
+			char u[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF] };
+			jctl_out_write(o, u, 6);
+		}
+		}
+	}
+	jctl_out_write(o, s + run, n - run);
+	jctl_out_write(o, "\"", 1);
+}
+
+
+/*
+ * Add the 'n' bytes of string 's' as CSV field to the output of writer 'o'.
+ * Fields with separators, quotes or line breaks are quoted,
+ * with their quotes doubled, others are written as they are.
+ */
+static void jctl_emit_csv_field (jctl_out *o, const char *s, size_t n)
+{
+	size_t i = 0;
+	while(i < n && s[i] != ',' && s[i] != '"' && s[i] != '\n' && s[i] != '\r')
+		++i;
+	if(i == n)
+	{
+		jctl_out_write(o, s, n);
+		return;
+	}
+
+	size_t run = 0;
+	jctl_out_write(o, "\"", 1);
+	for(; i < n; ++i)
+	{
+		if(s[i] != '"')
+			continue;
+		/* the quote ends the run, and starts the next one again */
+		jctl_out_write(o, s + run, i + 1 - run);
+		run = i;
+	}
+	jctl_out_write(o, s + run, n - run);
+	jctl_out_write(o, "\"", 1);
+}
+
+
+/*
+ * Start the output of format 'f' with writer 'o',
+ * the header row of CSV and the header of the binary format.
+ */
+void jctl_emit_begin (jctl_out *o, jctl_emit_format f)
+{
+	if(f == JCTL_EMIT_CSV)
+	{
+		jctl_out_write(o, "path,lines,bytes,dirlen\n", 24);
+	}
+	else if(f == JCTL_EMIT_BIN)
+	{
+		jctl_emit_header(o, JCTL_EMIT_BIN_MAGIC, JCTL_EMIT_BIN_VERSION);
+	}
+}
+
+
+/*
+ * Add a header of the binary format to the output of writer 'o',
+ * with magic 'magic' (7 characters) and version 'version'.
+ * Snapshots share the format, with a magic of their own.
+ */
+void jctl_emit_header (jctl_out *o, const char *magic, jctl_uint version)
+{
+	unsigned char h[JCTL_EMIT_BIN_HEADER] = {0};
+	memcpy(h, magic, 7);
+	jctl_emit_le32(h + 8, version);
+	jctl_emit_le32(h + 12, JCTL_EMIT_BIN_HEADER);
+	jctl_out_write(o, (const char*) h, sizeof(h));
+}
+
+
+/*
+ * Add the record of a file to the output of writer 'o' in format 'f',
+ * of path 'path' of length 'len' with directory length 'dirlen',
+ * 'lines' lines and 'bytes' bytes.
+ * The whole record is reserved at once, so it's written at once
+ * even by a writer shared with other threads.
+ * A record that doesn't fit fails the writer, like a failed write.
+ */
+void jctl_emit_entry (jctl_out *o, jctl_emit_format f, const char *path, size_t len, jctl_size lines, jctl_size bytes, jctl_uint dirlen)
+{
+	switch(f)
+	{
+	case JCTL_EMIT_TEXT:
+		break;
+
+	case JCTL_EMIT_JSONL:
+		/* every byte of the path escaped as "\u00XX" or "\ufffd" at most */
+		if(jctl_out_reserve(o, len * 6 + 100))
+		{
+			o->err = 1;
+			return;
+		}
+		jctl_out_write(o, "{\"path\":", 8);
+		jctl_emit_json_string(o, path, len);
+		jctl_out_write(o, ",\"lines\":", 9);
+		jctl_out_uint(o, lines);
+		jctl_out_write(o, ",\"bytes\":", 9);
+		jctl_out_uint(o, bytes);
+		jctl_out_write(o, ",\"dirlen\":", 10);
+		jctl_out_uint(o, dirlen);
+		jctl_out_write(o, "}\n", 2);
+		break;
+
+	case JCTL_EMIT_CSV:
+		if(jctl_out_reserve(o, len * 2 + 70))
+		{
+			o->err = 1;
+			return;
+		}
+		jctl_emit_csv_field(o, path, len);
+		jctl_out_write(o, ",", 1);
+		jctl_out_uint(o, lines);
+		jctl_out_write(o, ",", 1);
+		jctl_out_uint(o, bytes);
+		jctl_out_write(o, ",", 1);
+		jctl_out_uint(o, dirlen);
+		jctl_out_write(o, "\n", 1);
+		break;
+
+	case JCTL_EMIT_BIN:
+	{
+		/* the terminator and padding follow the path */
+		size_t size = (sizeof(jctl_emit_record) + len + JCTL_EMIT_BIN_ALIGN) & ~(size_t)(JCTL_EMIT_BIN_ALIGN - 1);
+		if(jctl_out_reserve(o, size))
+		{
+			o->err = 1;
+			return;
+		}
+
+		unsigned char r[sizeof(jctl_emit_record)];
+		jctl_emit_le32(r + offsetof(jctl_emit_record, size), (uint32_t) size);
+		jctl_emit_le32(r + offsetof(jctl_emit_record, pathlen), (uint32_t) len);
+		jctl_emit_le64(r + offsetof(jctl_emit_record, lines), lines);
+		jctl_emit_le64(r + offsetof(jctl_emit_record, bytes), bytes);
+		jctl_emit_le32(r + offsetof(jctl_emit_record, dirlen), dirlen);
+		jctl_emit_le32(r + offsetof(jctl_emit_record, reserved), 0);
+		jctl_out_write(o, (const char*) r, sizeof(r));
+		jctl_out_write(o, path, len);
+		jctl_out_fill(o, '\0', size - sizeof(r) - len);
+		break;
+	}
+	}
+}
@@ -0,0 +1,70 @@
+#ifndef JCTL_EMIT_H
+#define JCTL_EMIT_H
+
+#include "jctl.h"
+#include "out.h"
+#include <stddef.h>
+#include <stdint.h>
+
+
+/*
+ * Header of the binary format, 'JCTL_EMIT_BIN_MAGIC' (8 bytes
+ * with its terminator) followed by the version and the header size
+ * as 32 bit little endian numbers.
+ */
+#define JCTL_EMIT_BIN_MAGIC		"JCTLBIN"
+#define JCTL_EMIT_BIN_VERSION	(1)
+#define JCTL_EMIT_BIN_HEADER	(16)
+
+/*
+ * Records of the binary format start
+ * and end on multiples of 8 bytes.
+ */
+#define JCTL_EMIT_BIN_ALIGN		(8)
+
+
+/*
+*
+* Emit Format
+*
+* Output format of the counted files,
+* all but the text graph have a record per file and no total.
+*
+*/
+typedef enum jctl_emit_format_e
+{
+	JCTL_EMIT_TEXT,		/* padded graph, made by 'jctl_graph_print' */
+	JCTL_EMIT_JSONL,	/* a JSON object per line */
+	JCTL_EMIT_CSV,		/* RFC 4180 rows below a header row */
+	JCTL_EMIT_BIN		/* length prefixed binary records */
+} jctl_emit_format;
+
+
+/*
+*
+* Binary Record
+*
+* Layout of a record of the binary format, little endian,
+* so a reader can map the output and step from record to record
+* by 'size' without parsing anything.
+* 'path' is terminated and zero padded up to 'size'.
+*
+*/
+typedef struct jctl_emit_record_s
+{
+	uint32_t size;		/* record size, a multiple of JCTL_EMIT_BIN_ALIGN */
+	uint32_t pathlen;	/* path length, without terminator */
+	uint64_t lines;		/* line count */
+	uint64_t bytes;		/* file size */
+	uint32_t dirlen;	/* directory length of the path */
+	uint32_t reserved;	/* 0 */
+	char path[];		/* path */
+} jctl_emit_record;
+
+
+void	jctl_emit_begin		(jctl_out *o, jctl_emit_format f);
+void	jctl_emit_header	(jctl_out *o, const char *magic, jctl_uint version);
+void	jctl_emit_entry		(jctl_out *o, jctl_emit_format f, const char *path, size_t len, jctl_size lines, jctl_size bytes, jctl_uint dirlen);
+
+
+#endif /* JCTL_EMIT_H */
@@ -1,68 +1,682 @@
-#include "file.h"
-#include "tinydir.h"
-#include <stdio.h>
-
-#define is_newline(c) (((c) == '\n') || ((c) == '\r'))
-
-
-/*
- * Return the line count of file of name 'fn'.
- * Supports the following line break types:
- * - CR   : Commodore, Apple II, Mac OS, ...
- * - LF   : Unix and Unix-like systems
- * - CRLF : Windows, DOS, ...
- */
-jctl_uint jctl_file_linecount (char *fn)
-{
-	if(fn == NULL)
-		return 0;
-
-	FILE *fp = fopen(fn, "r");
-	jctl_uint lc = 1;
-
-	if(fp != NULL)
-	{
-		while(!feof(fp))
-		{
-			char c1 = fgetc(fp);
-			if(is_newline(c1))
-			{
-				++lc;
-				char c2 = fgetc(fp);
-				if(is_newline(c2))
-					lc += (c1 == c2);
-			}
-		}
-	}
-
-	return lc;
-}
-
-
-/*
- * Check if file "fn" exists.
- * Return 1 if it does,
- * otherwise return 0.
- */
-jctl_uint jctl_file_exists (char *fn)
-{
-	if(fn == NULL)
-		return 0;
-
-	FILE *fp = fopen(fn, "r");
-	
-	return (fp != NULL);
-}
-
-
-/*
- * Returns the file count in directory 'path'.
- */
-jctl_uint jctl_dir_filecount (char *path)
-{
-	tinydir_dir dir;
-	tinydir_open_sorted(&dir, ".");
-	jctl_uint fc = dir.n_files;
-	tinydir_close(&dir);
-	return fc;
-}
+#define _FILE_OFFSET_BITS 64
+
+/* O_NOATIME */
+#ifdef __linux__
+	#define _GNU_SOURCE
+#endif
+
+#include "file.h"
+#include "count.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+	#include <io.h>
+#else
+	#include <unistd.h>
+#endif
+
+#if defined(__unix__) || (defined(__APPLE__) && defined(__MACH__))
+	#define JCTL_FILE_MMAP
+	#include <sys/mman.h>
+	#include <setjmp.h>
+	#include <signal.h>
+#endif
+
+/*
+ * Files can be opened relative to an open directory.
+ */
+#ifndef _WIN32
+	#define JCTL_FILE_AT
+#endif
+
+#ifndef O_BINARY
+	#define O_BINARY (0)
+#endif
+
+#ifndef O_CLOEXEC
+	#define O_CLOEXEC (0)
+#endif
+
+
+#ifdef JCTL_FILE_MMAP
+/*
+ * Jump buffer of the thread counting a mapped file, NULL if none.
+ * Touching a page past the end of a file truncated while mapped
+ * raises SIGBUS, which jumps back to the count.
+ */
+static _Thread_local sigjmp_buf *jctl_file_bus;
+
+
+/*
+ * Handle signal 'sig', a SIGBUS raised by a mapped count,
+ * one raised anywhere else is fatal as usual.
+ */
+static void jctl_file_sigbus (int sig)
+{
+	if(jctl_file_bus != NULL)
+		siglongjmp(*jctl_file_bus, 1);
+
+	signal(sig, SIG_DFL);
+	raise(sig);
+}
+#endif /* defined(JCTL_FILE_MMAP) */
+
+
+/*
+ * Set up counting files, catching the SIGBUS
+ * of a file truncated while it is mapped.
+ * Must be called once at startup, before any counting.
+ */
+void jctl_file_setup (void)
+{
+#ifdef JCTL_FILE_MMAP
+	struct sigaction sa;
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = jctl_file_sigbus;
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGBUS, &sa, NULL);
+#endif /* defined(JCTL_FILE_MMAP) */
+}
+
+
+/*
+ * Allocate read buffer 'b' of 'size' bytes.
+ * The buffer is meant to be allocated once
+ * and reused for every counted file.
+ *
+ * Return 0 if the buffer got allocated,
+ * otherwise return 1.
+ */
+jctl_uint jctl_file_buffer_init (jctl_file_buffer *b, size_t size)
+{
+	b->p = (char*)malloc(size);
+	b->size = size;
+	return (b->p == NULL);
+}
+
+
+/*
+ * Free read buffer 'b'.
+ */
+void jctl_file_buffer_free (jctl_file_buffer *b)
+{
+	free(b->p);
+	b->p = NULL;
+	b->size = 0;
+}
+
+
+/*
+ * Open file 'fn' for reading, relative to the open
+ * directory 'dirfd' or the working directory if it is -1.
+ * Return the file descriptor, or -1 on failure.
+ */
+static int jctl_file_openat (int dirfd, const char *fn, int flags)
+{
+#ifdef JCTL_FILE_AT
+	if(dirfd >= 0)
+		return openat(dirfd, fn, flags);
+#endif /* defined(JCTL_FILE_AT) */
+	return open(fn, flags);
+}
+
+
+/*
+ * Open file 'fn' for reading, relative to directory 'dirfd'
+ * as with 'jctl_file_openat'.
+ * Avoids updating the access time where allowed,
+ * O_NOATIME is refused for files the user doesn't own.
+ * Return the file descriptor, or -1 on failure.
+ */
+static int jctl_file_open (int dirfd, const char *fn)
+{
+	int flags = O_RDONLY | O_BINARY | O_CLOEXEC;
+	int fd;
+
+#ifdef O_NOATIME
+	fd = jctl_file_openat(dirfd, fn, flags | O_NOATIME);
+	if(fd >= 0 || errno != EPERM)
+		return fd;
+#endif /* defined(O_NOATIME) */
+
+	do fd = jctl_file_openat(dirfd, fn, flags);
+	while(fd < 0 && errno == EINTR);
+
+	return fd;
+}
+
+
+/*
+ * Get the status of file 'fn' into 'st', relative to
+ * directory 'dirfd' as with 'jctl_file_openat'.
+ * Symbolic links are followed.
+ * Return 0 on success, otherwise return -1.
+ */
+static int jctl_file_statat (int dirfd, const char *fn, struct stat *st)
+{
+#ifdef JCTL_FILE_AT
+	if(dirfd >= 0)
+		return fstatat(dirfd, fn, st, 0);
+#endif /* defined(JCTL_FILE_AT) */
+	return stat(fn, st);
+}
+
+
+/*
+ * Read up to 'n' bytes at offset 'off' of file 'fd' into 'p'.
+ */
+static long long jctl_file_pread (int fd, char *p, size_t n, jctl_size off)
+{
+#ifdef _WIN32
+	if(_lseeki64(fd, (__int64) off, SEEK_SET) < 0)
+		return -1;
+	return read(fd, p, (unsigned int) n);
+#else
+	return pread(fd, p, n, (off_t) off);
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * Move the position of file 'fd' to offset 'off'.
+ * Return 0 on success, otherwise return 1.
+ */
+static int jctl_file_seek (int fd, jctl_size off)
+{
+#ifdef _WIN32
+	return (_lseeki64(fd, (__int64) off, SEEK_SET) < 0);
+#else
+	return (lseek(fd, (off_t) off, SEEK_SET) < 0);
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * Return the checksum (64-bit FNV-1a) of the 'n' bytes of 'p'.
+ */
+static jctl_size jctl_file_sum (const char *p, size_t n)
+{
+	jctl_size h = 0xCBF29CE484222325ULL;
+	for(size_t i = 0; i < n; ++i)
+	{
+		h ^= (unsigned char) p[i];
+		h *= 0x100000001B3ULL;
+	}
+	return h;
+}
+
+
+/*
+ * Checksum the last JCTL_FILE_TAIL bytes before offset 'end'
+ * of file 'fd' (all of them if there are fewer) into 'sum'.
+ * The bytes are taken from 'p' if its 'n' bytes
+ * are the ones right before 'end', otherwise they get read.
+ * Return 0 on success, otherwise return 1.
+ */
+static int jctl_file_tail_sum (int fd, jctl_size end, const char *p, size_t n, jctl_size *sum)
+{
+	size_t want = (end < JCTL_FILE_TAIL) ? (size_t) end : JCTL_FILE_TAIL;
+
+	if(n >= want)
+	{
+		*sum = jctl_file_sum(p + n - want, want);
+		return 0;
+	}
+
+	char tail[JCTL_FILE_TAIL];
+	for(size_t got = 0; got < want;)
+	{
+		long long r = jctl_file_pread(fd, tail + got, want - got, end - want + got);
+		if(r < 0 && errno == EINTR)
+			continue;
+		if(r <= 0)
+			return 1;
+		got += (size_t) r;
+	}
+
+	*sum = jctl_file_sum(tail, want);
+	return 0;
+}
+
+
+#ifdef JCTL_FILE_MMAP
+/*
+ * Count the lines of the open file 'fd' by mapping it into memory,
+ * which saves copying every byte into the read buffer first.
+ * Fills tail 't' unless it is NULL.
+ *
+ * The file is counted JCTL_FILE_MMAP_STEP bytes at a time.
+ * If it gets truncated meanwhile (as 'copytruncate' log rotation does),
+ * the count of the step that faulted is thrown away and the file
+ * is left positioned at its start, in '*off', to be read from there.
+ *
+ * Return 0 on success, -1 if the file can't be positioned,
+ * otherwise return 1 and leave the file to be read the usual way.
+ */
+static int jctl_file_linecount_mmap (int fd, struct stat *st, jctl_count *c, jctl_file_tail *t, jctl_size *off)
+{
+	/*
+	 * Only regular files big enough for the mapping
+	 * to pay off, pipes and special files can't be mapped.
+	 */
+	if(!S_ISREG(st->st_mode))
+		return 1;
+	if(st->st_size < JCTL_FILE_MMAP_MIN || (uintmax_t) st->st_size > SIZE_MAX)
+		return 1;
+
+	size_t size = (size_t) st->st_size;
+	void *p = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if(p == MAP_FAILED)
+		return 1;
+
+#ifdef MADV_SEQUENTIAL
+	madvise(p, size, MADV_SEQUENTIAL);
+#endif
+#if JCTL_FILE_MMAP_HUGEPAGE && defined(MADV_HUGEPAGE)
+	madvise(p, size, MADV_HUGEPAGE);
+#endif
+
+	sigjmp_buf env;
+	size_t done;
+	size_t n;
+
+	for(done = 0; done < size; done += n)
+	{
+		n = (size - done < JCTL_FILE_MMAP_STEP) ? size - done : JCTL_FILE_MMAP_STEP;
+
+		/* set before the jump buffer, so it's still valid after a jump */
+		jctl_count saved = *c;
+		if(sigsetjmp(env, 1))
+		{
+			jctl_file_bus = NULL;
+			*c = saved;
+			break;
+		}
+
+		jctl_file_bus = &env;
+		jctl_count_block(c, (const char*) p + done, n);
+		jctl_file_bus = NULL;
+	}
+
+	munmap(p, size);
+
+	if(done < size)
+	{
+		*off = done;
+		return jctl_file_seek(fd, done) ? -1 : 1;
+	}
+
+	/* the tail gets read, the mapping may be gone past it by now */
+	if(t != NULL)
+	{
+		t->size = size;
+		if(jctl_file_tail_sum(fd, size, NULL, 0, &t->sum))
+			t->size = 0;
+	}
+
+	return 0;
+}
+#endif /* defined(JCTL_FILE_MMAP) */
+
+
+/*
+ * Count the lines of the open file 'fd' from its current position
+ * by streaming it through read buffer 'b'.
+ * Unless tail 't' is NULL, the bytes read get added to 't->size'
+ * and the last of them checksummed into 't->sum'.
+ * Return 0 on success, otherwise return 1.
+ */
+static int jctl_file_linecount_read (jctl_file_buffer *b, int fd, jctl_count *c, jctl_file_tail *t)
+{
+#if defined(POSIX_FADV_SEQUENTIAL)
+	posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+	size_t last = 0;
+
+	for(;;)
+	{
+		ssize_t n = read(fd, b->p, b->size);
+		if(n > 0)
+		{
+			jctl_count_block(c, b->p, (size_t) n);
+			last = (size_t) n;
+			if(t != NULL)
+				t->size += (size_t) n;
+		}
+		else if(n == 0)
+			break;
+		else if(errno != EINTR)
+			return 1;
+	}
+
+	/* the buffer still holds the last block read */
+	if(t != NULL && jctl_file_tail_sum(fd, t->size, b->p, last, &t->sum))
+		t->size = 0;
+
+	return 0;
+}
+
+
+/*
+ * Count the lines of file of name 'fn' into 'c', using read buffer 'b'.
+ * 'fn' is relative to directory 'dirfd' as with 'jctl_file_openat'.
+ *
+ * If 't' isn't NULL and holds the tail of an earlier count,
+ * the count goes on from there if the file only got appended to:
+ * it didn't shrink and the bytes before the old end are unchanged.
+ * Otherwise the whole file is counted.
+ * Either way 't' gets the tail of this count.
+ *
+ * Return 0 if the file got counted,
+ * otherwise (the file can't be opened or read) return 1.
+ */
+static int jctl_file_count (jctl_file_buffer *b, int dirfd, char *fn, jctl_count *c, jctl_file_tail *t)
+{
+	jctl_count_init(c);
+
+	if(fn == NULL)
+		return 1;
+
+	int fd = jctl_file_open(dirfd, fn);
+	if(fd < 0)
+		return 1;
+
+	struct stat st;
+	int err = (fstat(fd, &st) != 0);
+	jctl_size off = 0;
+
+	if(!err && t != NULL && t->size > 0)
+	{
+		jctl_size sum;
+		if(S_ISREG(st.st_mode) && (jctl_size) st.st_size >= t->size
+		&& jctl_file_tail_sum(fd, t->size, NULL, 0, &sum) == 0 && sum == t->sum
+		&& jctl_file_seek(fd, t->size) == 0)
+		{
+			c->lc = t->lc;
+			c->pend = t->pend;
+			off = t->size;
+		}
+	}
+
+	int mapped = 0;
+
+#ifdef JCTL_FILE_MMAP
+	if(!err && off == 0)
+	{
+		int r = jctl_file_linecount_mmap(fd, &st, c, t, &off);
+		mapped = (r == 0);
+		err = (r < 0);
+	}
+#endif /* defined(JCTL_FILE_MMAP) */
+
+	if(!err && !mapped)
+	{
+		if(t != NULL)
+			t->size = off;
+		err = jctl_file_linecount_read(b, fd, c, t);
+	}
+
+	close(fd);
+
+	if(t != NULL)
+	{
+		t->lc = c->lc;
+		t->pend = c->pend;
+	}
+	return err;
+}
+
+
+/*
+ * Count the lines of file of name 'fn' into 'lc',
+ * using read buffer 'b'.
+ * Supports the following line break types:
+ * - CR   : Commodore, Apple II, Mac OS, ...
+ * - LF   : Unix and Unix-like systems
+ * - CRLF : Windows, DOS, ...
+ *
+ * Return 0 if the file got counted,
+ * otherwise (the file can't be opened or read) return 1.
+ */
+jctl_uint jctl_file_linecount (jctl_file_buffer *b, char *fn, jctl_size *lc)
+{
+	jctl_count c;
+	int err = jctl_file_count(b, -1, fn, &c, NULL);
+	*lc = 1 + c.lc;
+	return err;
+}
+
+
+/*
+ * Count the lines of file of name 'fn' into 'lc' like 'jctl_file_linecount',
+ * with 'fn' relative to the open directory 'dirfd' (-1 for none),
+ * which saves the system looking up the whole path again.
+ *
+ * Unless 't' is NULL, counting goes on from the earlier count of tail 't'
+ * if the file only got appended to since (see 'jctl_file_count').
+ * 't->size' set to 0 means there is no earlier count.
+ * 't' gets the tail of this count.
+ *
+ * Return 0 if the file got counted,
+ * otherwise (the file can't be opened or read) return 1.
+ */
+jctl_uint jctl_file_linecount_at (jctl_file_buffer *b, int dirfd, char *fn, jctl_file_tail *t, jctl_size *lc)
+{
+	jctl_count c;
+	int err = jctl_file_count(b, dirfd, fn, &c, t);
+	*lc = 1 + c.lc;
+	return err;
+}
+
+
+/*
+ * Move offset 'off' of file 'fd' forward until the byte
+ * before it is neither CR nor LF (or until the end of file),
+ * but not past 'limit', reading through read buffer 'b'.
+ *
+ * A line break never continues past such a byte,
+ * so counting can start there without knowing anything
+ * about the bytes before it.
+ */
+static jctl_size jctl_file_align (jctl_file_buffer *b, int fd, jctl_size off, jctl_size limit)
+{
+	if(off == 0)
+		return 0;
+
+	jctl_size pos = off - 1;
+
+	while(pos < limit)
+	{
+		size_t want = b->size;
+		if(limit - pos < want)
+			want = (size_t)(limit - pos);
+
+		long long n = jctl_file_pread(fd, b->p, want, pos);
+		if(n < 0 && errno == EINTR)
+			continue;
+		if(n <= 0)
+			return pos;
+
+		for(long long i = 0; i < n; ++i)
+			if(b->p[i] != '\n' && b->p[i] != '\r')
+				return pos + i + 1;
+
+		pos += n;
+	}
+
+	return limit;
+}
+
+
+/*
+ * Count the line breaks of the byte range 'start' to 'end'
+ * of file of name 'fn' into tail 't', using read buffer 'b'.
+ * 'end' may be JCTL_FILE_EOF to count until the end of file,
+ * only then 't->sum' gets set.
+ *
+ * Both ends get moved forward by 'jctl_file_align',
+ * so a CRLF pair straddling the boundary of two neighbouring
+ * ranges is counted by exactly one of them.
+ * The start only moves as far as the end: a range within
+ * a run of line breaks is empty, 't->size' is 0 then,
+ * and the range before it counts the run up to its end.
+ * The line breaks of all ranges of a file add up to
+ * what 'jctl_file_linecount' returns, minus its initial line,
+ * and the tail of the last range is the tail of the whole file,
+ * but for the pending line break of a range starting at the end
+ * of file, which is the one of the last range counting any bytes.
+ *
+ * Return 0 if the range got counted,
+ * otherwise (the file can't be opened or read) return 1.
+ */
+jctl_uint jctl_file_linecount_range (jctl_file_buffer *b, char *fn, jctl_size start, jctl_size end, jctl_file_tail *t)
+{
+	int fd = jctl_file_open(-1, fn);
+	if(fd < 0)
+		return 1;
+
+	int eof = (end == JCTL_FILE_EOF);
+	start = jctl_file_align(b, fd, start, end);
+	if(!eof && start >= end)
+	{
+		t->size = 0;
+		t->lc = 0;
+		t->pend = 0;
+		t->sum = 0;
+		close(fd);
+		return 0;
+	}
+	if(!eof)
+		end = jctl_file_align(b, fd, end, JCTL_FILE_EOF);
+
+#if defined(POSIX_FADV_SEQUENTIAL)
+	posix_fadvise(fd, (off_t) start, eof ? 0 : (off_t)(end - start), POSIX_FADV_SEQUENTIAL);
+#endif
+
+	jctl_count c;
+	jctl_count_init(&c);
+	int err = 0;
+	size_t last = 0;
+	jctl_size off;
+
+	for(off = start; off < end;)
+	{
+		size_t want = b->size;
+		if(end - off < want)
+			want = (size_t)(end - off);
+
+		long long n = jctl_file_pread(fd, b->p, want, off);
+		if(n > 0)
+		{
+			jctl_count_block(&c, b->p, (size_t) n);
+			off += n;
+			last = (size_t) n;
+		}
+		else if(n == 0)
+			break;
+		else if(errno != EINTR)
+		{
+			err = 1;
+			break;
+		}
+	}
+
+	t->size = off;
+	t->lc = c.lc;
+	t->pend = c.pend;
+	t->sum = 0;
+
+	/* the buffer still holds the last block read */
+	if(eof && !err && jctl_file_tail_sum(fd, off, b->p, last, &t->sum))
+		t->size = 0;
+
+	close(fd);
+	return err;
+}
+
+
+/*
+ * Fill 'fi' with the information of 'st'.
+ */
+static void jctl_file_info_set (jctl_file_info *fi, struct stat *st)
+{
+	/* pipes and special files have no known size */
+	fi->reg = S_ISREG(st->st_mode);
+	fi->size = fi->reg ? (jctl_size) st->st_size : 0;
+	fi->dev = (jctl_size) st->st_dev;
+	fi->ino = (jctl_size) st->st_ino;
+	fi->mtime = (long long) st->st_mtime;
+
+#if defined(__APPLE__)
+	fi->mtimens = st->st_mtimespec.tv_nsec;
+#elif defined(_WIN32)
+	fi->mtimens = 0;
+#else
+	fi->mtimens = st->st_mtim.tv_nsec;
+#endif
+}
+
+
+/*
+ * Fill 'fi' with the information about file "fn".
+ * Return 0 if the file exists and is not a directory,
+ * otherwise return 1.
+ */
+jctl_uint jctl_file_stat (char *fn, jctl_file_info *fi)
+{
+	return jctl_file_stat_at(-1, fn, fi);
+}
+
+
+/*
+ * Fill 'fi' with the information about file "fn",
+ * relative to the open directory 'dirfd' (-1 for none).
+ * Return 0 if the file exists and is not a directory,
+ * otherwise return 1.
+ */
+jctl_uint jctl_file_stat_at (int dirfd, char *fn, jctl_file_info *fi)
+{
+	if(fn == NULL)
+		return 1;
+
+	struct stat st;
+	if(jctl_file_statat(dirfd, fn, &st) != 0 || S_ISDIR(st.st_mode))
+		return 1;
+
+	jctl_file_info_set(fi, &st);
+	return 0;
+}
+
+
+/*
+ * Fill 'fi' with the information about directory 'path'.
+ * Return 0 if it is a directory,
+ * otherwise return 1.
+ */
+jctl_uint jctl_dir_stat (char *path, jctl_file_info *fi)
+{
+	return jctl_dir_stat_at(-1, path, fi);
+}
+
+
+/*
+ * Fill 'fi' with the information about directory 'path',
+ * relative to the open directory 'dirfd' (-1 for none).
+ * Return 0 if it is a directory,
+ * otherwise return 1.
+ */
+jctl_uint jctl_dir_stat_at (int dirfd, char *path, jctl_file_info *fi)
+{
+	struct stat st;
+	if(jctl_file_statat(dirfd, path, &st) != 0 || !S_ISDIR(st.st_mode))
+		return 1;
+
+	jctl_file_info_set(fi, &st);
+	return 0;
+}
@@ -1,24 +1,128 @@
-#ifndef JCTL_FILE_H
-#define JCTL_FILE_H
-
-#include "jctl.h"
-#include "ofp/ofp.h"
-
-
-/*
-*
-* File
-*
-*/
-jctl_uint jctl_file_linecount	(char *fn);
-jctl_uint jctl_file_exists		(char *fn);
-
-/*
-*
-* Directory
-*
-*/
-jctl_uint jctl_dir_filecount	(char *path);
-
-
-#endif /* JCTL_FILE_H */
+#ifndef JCTL_FILE_H
+#define JCTL_FILE_H
+
+#include "jctl.h"
+#include "ofp/ofp.h"
+
+
+/*
+ * Smallest file size worth mapping into memory.
+ * Smaller files, pipes and special files
+ * are streamed through the read buffer instead.
+ */
+#define JCTL_FILE_MMAP_MIN		(1024 * 1024)
+
+/*
+ * Bytes of a mapped file counted at a time, a file truncated
+ * while mapped is read on from the start of the step it happened in.
+ */
+#define JCTL_FILE_MMAP_STEP		(16 * 1024 * 1024)
+
+/*
+ * Ask the kernel to back mapped files with huge pages.
+ * Only has an effect on kernels that support
+ * huge pages for the page cache.
+ */
+#ifndef JCTL_FILE_MMAP_HUGEPAGE
+	#define JCTL_FILE_MMAP_HUGEPAGE	(0)
+#endif
+
+
+/*
+ * Bounds and default size of the read buffer
+ * files get streamed through while being counted.
+ */
+#define JCTL_FILE_BUFSIZE_MIN		(256 * 1024)
+#define JCTL_FILE_BUFSIZE_MAX		(4 * 1024 * 1024)
+#define JCTL_FILE_BUFSIZE_DEFAULT	(256 * 1024)
+
+
+/*
+ * End of a range counted until the end of file.
+ */
+#define JCTL_FILE_EOF				((jctl_size) -1)
+
+/*
+ * Amount of bytes at the end of a count checksummed,
+ * to tell whether a file only got appended to since.
+ */
+#define JCTL_FILE_TAIL				(4 * 1024)
+
+
+/*
+*
+* File Information
+*
+*/
+typedef struct jctl_file_info_s
+{
+	jctl_size size;		/* size in bytes */
+	jctl_uint reg;		/* regular file */
+	jctl_size dev;		/* device */
+	jctl_size ino;		/* inode, 0 if the system has none */
+	long long mtime;	/* modification time, seconds */
+	long mtimens;		/* modification time, nanoseconds */
+} jctl_file_info;
+
+
+/*
+*
+* File Tail
+*
+* Where the count of a file stopped, so a later count
+* of the grown file can go on from there.
+*
+*/
+typedef struct jctl_file_tail_s
+{
+	jctl_size size;		/* bytes counted, 0 if unknown */
+	jctl_size lc;		/* line breaks counted */
+	int pend;			/* line break waiting for its pair, 0 if none */
+	jctl_size sum;		/* checksum of the last JCTL_FILE_TAIL bytes counted */
+} jctl_file_tail;
+
+
+/*
+*
+* Read Buffer
+*
+* Allocated once and reused for every counted file.
+*
+*/
+typedef struct jctl_file_buffer_s
+{
+	char *p;		/* buffer */
+	size_t size;	/* buffer size */
+} jctl_file_buffer;
+
+
+/*
+*
+* Buffer
+*
+*/
+void		jctl_file_setup			(void);
+jctl_uint	jctl_file_buffer_init	(jctl_file_buffer *b, size_t size);
+void		jctl_file_buffer_free	(jctl_file_buffer *b);
+
+/*
+*
+* File
+*
+*/
+jctl_uint	jctl_file_linecount		(jctl_file_buffer *b, char *fn, jctl_size *lc);
+jctl_uint	jctl_file_linecount_at	(jctl_file_buffer *b, int dirfd, char *fn, jctl_file_tail *t, jctl_size *lc);
+jctl_uint	jctl_file_linecount_range	(jctl_file_buffer *b, char *fn, jctl_size start, jctl_size end, jctl_file_tail *t);
+jctl_uint	jctl_file_stat			(char *fn, jctl_file_info *fi);
+jctl_uint	jctl_file_stat_at		(int dirfd, char *fn, jctl_file_info *fi);
+
+/*
+*
+* Directory
+*
+*/
+jctl_uint	jctl_dir_stat			(char *path, jctl_file_info *fi);
+jctl_uint	jctl_dir_stat_at		(int dirfd, char *path, jctl_file_info *fi);
+
+
+#endif /* JCTL_FILE_H */
@@ -0,0 +1,206 @@
+#include "filter.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+/*
+ * Return the hash of extension 'ext' of length 'len'.
+ */
+static size_t jctl_filter_hash (const char *ext, size_t len)
+{
+	size_t h = 2166136261u;
+	for(size_t i = 0; i < len; ++i)
+		h = (h ^ (unsigned char) ext[i]) * 16777619u;
+	return h;
+}
+
+
+/*
+ * Return the slot of extension 'ext' of length 'len' in filter 'f',
+ * or the empty slot it would go into.
+ */
+static jctl_filter_ext *jctl_filter_probe (const jctl_filter *f, const char *ext, size_t len)
+{
+	size_t mask = f->extcap - 1;
+	size_t i = jctl_filter_hash(ext, len) & mask;
+
+	for(;; i = (i + 1) & mask)
+	{
+		jctl_filter_ext *x = f->exts + i;
+		if(x->ext == NULL || (x->len == len && memcmp(x->ext, ext, len) == 0))
+			return x;
+	}
+}
+
+
+/*
+ * Return the extension of pattern 'p' if it is
+ * a plain "*.ext" pattern, otherwise return NULL.
+ */
+static const char *jctl_filter_plain (const char *p)
+{
+	if(p[0] != '*' || p[1] != '.' || p[2] == '\0')
+		return NULL;
+	if(strpbrk(p + 2, "*?[]\\.") != NULL)
+		return NULL;
+	return p + 2;
+}
+
+
+/*
+ * Split the comma separated pattern list 'list' in place,
+ * appending its patterns to 'out' from index 'n'.
+ * A backslash escapes a comma, which then stays part of the pattern.
+ * Return the new pattern count.
+ */
+static jctl_uint jctl_filter_split (char *list, const char **out, jctl_uint n)
+{
+	char *p = list;
+	char *start = list;
+
+	for(;; ++p)
+	{
+		if(*p == '\\' && p[1] != '\0')
+		{
+			++p;
+			continue;
+		}
+		if(*p != ',' && *p != '\0')
+			continue;
+
+		int end = (*p == '\0');
+		*p = '\0';
+		if(*start != '\0')
+			out[n++] = start;
+		if(end)
+			return n;
+		start = p + 1;
+	}
+}
+
+
+/*
+ * Build filter 'f' of the comma separated pattern lists
+ * 'include' and 'exclude', either may be NULL.
+ * Return 0 on success, otherwise return 1,
+ * with '*bad' pointing to the invalid pattern
+ * or NULL if out of memory.
+ * The filter has to be freed either way,
+ * '*bad' stays valid until then.
+ */
+jctl_uint jctl_filter_init (jctl_filter *f, const char *include, const char *exclude, const char **bad)
+{
+	memset(f, 0, sizeof(*f));
+	*bad = NULL;
+
+	size_t ilen = include ? strlen(include) + 1 : 0;
+	size_t elen = exclude ? strlen(exclude) + 1 : 0;
+
+	/* every pattern takes at least one character and a comma */
+	jctl_uint max = (jctl_uint)((ilen + elen) / 2 + 2);
+	const char **all = (const char**)malloc(sizeof(*all) * max);
+	f->buf = (char*)malloc(ilen + elen + 1);
+	f->patterns = (const char**)malloc(sizeof(*f->patterns) * max);
+	if(all == NULL || f->buf == NULL || f->patterns == NULL)
+		goto fail;
+
+	if(include)
+		memcpy(f->buf, include, ilen);
+	if(exclude)
+		memcpy(f->buf + ilen, exclude, elen);
+
+	jctl_uint ni = include ? jctl_filter_split(f->buf, all, 0) : 0;
+	jctl_uint n = exclude ? jctl_filter_split(f->buf + ilen, all, ni) : ni;
+	f->include = (ni > 0);
+
+	jctl_uint nexts = 0;
+	for(jctl_uint i = 0; i < n; ++i)
+	{
+		if(wc_check(all[i]) != 0)
+		{
+			*bad = all[i];
+			goto fail;
+		}
+		nexts += (jctl_filter_plain(all[i]) != NULL);
+	}
+
+	/* at most half full */
+	if(nexts > 0)
+	{
+		for(f->extcap = 8; f->extcap < 2 * nexts; f->extcap *= 2);
+		f->exts = (jctl_filter_ext*)calloc(f->extcap, sizeof(*f->exts));
+		if(f->exts == NULL)
+			goto fail;
+	}
+
+	for(jctl_uint i = 0; i < n; ++i)
+	{
+		const char *ext = jctl_filter_plain(all[i]);
+		if(ext == NULL)
+		{
+			f->patterns[f->npatterns++] = all[i];
+			f->nincludes += (i < ni);
+			continue;
+		}
+
+		size_t len = strlen(ext);
+		jctl_filter_ext *x = jctl_filter_probe(f, ext, len);
+		x->ext = ext;
+		x->len = len;
+		x->flags |= (i < ni) ? JCTL_FILTER_INCLUDE : JCTL_FILTER_EXCLUDE;
+	}
+
+	if(f->npatterns > 0 && wc_compile_set(&f->dfa, f->patterns, f->npatterns))
+		goto fail;
+
+	free(all);
+	return 0;
+
+fail:
+	free(all);
+	return 1;
+}
+
+
+/*
+ * Free filter 'f'.
+ */
+void jctl_filter_free (jctl_filter *f)
+{
+	wc_free(&f->dfa);
+	free(f->exts);
+	free(f->patterns);
+	free(f->buf);
+	memset(f, 0, sizeof(*f));
+}
+
+
+/*
+ * Return 1 if file name 'name' of length 'len' passes filter 'f',
+ * that is no exclude pattern matches it and,
+ * if there are include patterns, one of them does.
+ */
+jctl_uint jctl_filter_match (const jctl_filter *f, const char *name, size_t len)
+{
+	jctl_uint flags = 0;
+
+	if(f->extcap > 0)
+	{
+		size_t dot = len;
+		while(dot > 0 && name[dot - 1] != '.')
+			--dot;
+		if(dot > 0)
+			flags = jctl_filter_probe(f, name + dot, len - dot)->flags;
+	}
+
+	if(f->npatterns > 0 && !(flags & JCTL_FILTER_EXCLUDE))
+	{
+		int i = wc_dfa_find(&f->dfa, name, len);
+		if(i >= 0)
+			flags |= ((jctl_uint) i < f->nincludes) ? JCTL_FILTER_INCLUDE : JCTL_FILTER_EXCLUDE;
+	}
+
+	if(flags & JCTL_FILTER_EXCLUDE)
+		return 0;
+	return (!f->include || (flags & JCTL_FILTER_INCLUDE));
+}
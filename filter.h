@@ -0,0 +1,62 @@
+#ifndef JCTL_FILTER_H
+#define JCTL_FILTER_H
+
+#include "jctl.h"
+#include "wildcard.h"
+
+
+/*
+ * Flags of a filter extension.
+ */
+#define JCTL_FILTER_INCLUDE		(1)
+#define JCTL_FILTER_EXCLUDE		(2)
+
+
+/*
+*
+* Filter Extension
+*
+* Extension of a plain "*.ext" pattern,
+* an open addressing hash table slot, empty if 'ext' is NULL.
+*
+*/
+typedef struct jctl_filter_ext_s
+{
+	const char *ext;		/* extension, without the dot */
+	size_t len;				/* extension length */
+	jctl_uint flags;		/* JCTL_FILTER_INCLUDE and/or JCTL_FILTER_EXCLUDE */
+} jctl_filter_ext;
+
+
+/*
+*
+* Filter
+*
+* Include and exclude patterns matched against file names.
+* Plain "*.ext" patterns are looked up by the extension of a name,
+* all other patterns are compiled into one automaton,
+* includes before excludes, so a name is classified
+* against every pattern in one pass.
+* Read only once built, shared by all threads.
+*
+*/
+typedef struct jctl_filter_s
+{
+	char *buf;					/* copy of the pattern lists, split at the commas */
+	const char **patterns;		/* compiled patterns, includes first */
+	jctl_uint npatterns;		/* compiled pattern count */
+	jctl_uint nincludes;		/* compiled include pattern count */
+	jctl_uint include;			/* there are include patterns */
+	jctl_filter_ext *exts;		/* extensions */
+	size_t extcap;				/* extension slots, a power of two, 0 if none */
+	wc_dfa dfa;					/* automaton of the compiled patterns */
+} jctl_filter;
+
+
+jctl_uint	jctl_filter_init	(jctl_filter *f, const char *include, const char *exclude, const char **bad);
+void		jctl_filter_free	(jctl_filter *f);
+
+jctl_uint	jctl_filter_match	(const jctl_filter *f, const char *name, size_t len);
+
+
+#endif /* JCTL_FILTER_H */
@@ -1,457 +1,2365 @@
-#include "graph.h"
-#include "file.h"
-#include "jctl.h"
-#include "ofp/state.h"
-#include "tinydir.h"
-#include "wildcard.h"
-
-#include <string.h>
-#include <stdlib.h>
-#include <stdio.h>
-
-
-static void jctl_graph_entry_new (ofp_state *S, jctl_graph *g, char *fn, jctl_uint fnlen, jctl_uint dirlen, jctl_uint wc);
-
-/*
- * Return the length of unsigned integer 'n'.
- * Used for linecount padding in 'jctl_graph_print'.
- */
-static jctl_uint numlen (ofp_uint n)
-{
-    if (n < 1e1)  return 1;
-    if (n < 1e2)  return 2;
-	if (n < 1e3)  return 3;
-	if (n < 1e4)  return 4;
-	if (n < 1e5)  return 5;
-	if (n < 1e6)  return 6;
-	if (n < 1e7)  return 7;
-	if (n < 1e8)  return 8;
-	if (n < 1e9)  return 9;
-	if (n < 1e10) return 10;
-	return 11;
-}
-
-
-/*
- * Throw an error for graph 'g'.
- */
-static inline int jctl_graph_throw (jctl_graph *g)
-{
-	longjmp(g->errbuf, 1);
-}
-
-
-/*
- * Compare two graph entries by name (alphabetically).
- * Used in 'jctl_graph_sort'.
- */
-static inline int jctl_graph_entry_compare_name (const void *a, const void *b)
-{
-	jctl_graph_entry *ea = (jctl_graph_entry*) a;
-	jctl_graph_entry *eb = (jctl_graph_entry*) b;
-	return _jctl_strcmp(ea->fn, eb->fn);
-}
-
-
-/* 
- * Compare two graph entries by line count (increasing).
- * Used in 'jctl_graph_sort'
- */
-static inline int jctl_graph_entry_compare_line_inc (const void *a, const void *b)
-{
-	jctl_graph_entry *ea = (jctl_graph_entry*) a;
-	jctl_graph_entry *eb = (jctl_graph_entry*) b;
-	return ea->lc - eb->lc;
-}
-
-
-/*
- * Compare two graph entries by line count (decreasing).
- * Used in 'jctl_graph_sort'.
- */
-static inline int jctl_graph_entry_compare_line_dec (const void *a, const void *b)
-{
-	jctl_graph_entry *ea = (jctl_graph_entry*) a;
-	jctl_graph_entry *eb = (jctl_graph_entry*) b;
-	return eb->lc - ea->lc;
-}
-
-
-/*
- * Sort graph entries given the sort order 'so' and graph 'g'.
- * Used the standard C quick sort implementation 'qsort'.
- */
-static void jctl_graph_sort (ofp_state *S, jctl_graph *g, jctl_graph_sortorder so)
-{
-	switch(so)
-	{
-	case JCTL_GRAPH_SORT_NAME:
-		_jctl_graph_sort(g->entries, g->entrytop, sizeof(*g->entries), jctl_graph_entry_compare_name);
-		break;
-	case JCTL_GRAPH_SORT_LINE_INC:
-		_jctl_graph_sort(g->entries, g->entrytop, sizeof(*g->entries), jctl_graph_entry_compare_line_inc);
-		break;
-	case JCTL_GRAPH_SORT_LINE_DEC:
-		_jctl_graph_sort(g->entries, g->entrytop, sizeof(*g->entries), jctl_graph_entry_compare_line_dec);
-		break;
-	}
-}
-
-
-/* 
- * Print the graph 'g'.
- * Includes padding for more readibilty.
- */
-static void jctl_graph_print (ofp_state *S, jctl_graph *g)
-{
-	jctl_uint max_padding;
-	if(g->hfnlen > g->hdirlen)
-		max_padding = g->hfnlen;
-	else
-		max_padding = g->hdirlen;
-
-	/*
-	 * Initialize the padding
-	 * buffers for printing.
-	 */
-	char space[max_padding + 1];
-	char equals[JCTL_GRAPH_BARS + 1];
-	memset(space, ' ', max_padding);
-	memset(equals, '=', JCTL_GRAPH_BARS);
-	space[max_padding] = '\0';
-	equals[JCTL_GRAPH_BARS] = '\0';
-
-	/*
-	 * No need to keep track of
-	 * the highest line count length.
-	 * The global line count will always
-	 * be the highest, so calculate
-	 * it's numeric length.
-	 */
-	jctl_uint hlclen = numlen(g->glc);
-
-	/*
-	 * Flag that specifies if
-	 * the slash should be taken
-	 * into account in entry padding.
-	 */
-	int incslsh = (g->hdirlen != 0);
-
-	/*
-	 * Iterate through graph entries
-	 * and print their data using the 'jctl_printf'
-	 * function including the padding.
-	 */
-	for(jctl_uint i = 0; i < g->entrytop; ++i)
-	{
-		jctl_graph_entry *e = g->entries + i;
-
-		/*
-		 * Flag that specifies if
-		 * the file resides in
-		 * executable's directory.
-		 */
-		int exedir = (e->dirlen == 0);
-
-		/* "directory" padding */
-		_jctl_printf("%.*s", g->hdirlen - e->dirlen + incslsh * exedir, space);
-
-		/* filename */
-		printf(e->fn);
-		/*
-		 * Free the filename
-		 * malloc'ed while interpreting
-		 * the wildcard in function 'jctl_graph_entry_wildcard'.
-		 */
-		if(e->wc)
-			free(e->fn);
-
-		/* "post-filename" padding */
-		_jctl_printf("%.*s", g->hfnlen - e->fnlen, space);
-		_jctl_printf(" | ");
-
-		/* line count */
-		_jctl_printf("%u", e->lc);
-		_jctl_printf("%.*s", hlclen - numlen(e->lc), space);
-		_jctl_printf(" line%s", (e->lc == 1) ? "  [" : "s [");
-
-		/* graph */
-		jctl_uint prc = e->lc * 100 / g->glc;
-		jctl_uint bars = prc * JCTL_GRAPH_BARS / 100;
-		_jctl_printf("%.*s", bars, equals);
-		_jctl_printf("%.*s", JCTL_GRAPH_BARS - bars, space);
-
-		/* percentage */
-		_jctl_printf("] %u%%\n", prc);
-	}
-
-	/* global line count */
-	_jctl_printf("%.*s", g->hfnlen + g->hdirlen + incslsh, space);
-	_jctl_printf("   %u line%s\n", g->glc, (g->glc == 1) ? "" : "s");
-}
-
-
-/*
- * Check if the graph entry with given filename 'fn' of length 'fnlen' exists.
- * Returns 1 if it does exists,
- * otherwise returns 0.
- */
-static int jctl_graph_entry_exists (ofp_state *S, jctl_graph *g, char *fn, jctl_uint fnlen)
-{
-	for(jctl_uint i = 0; i < g->entrytop; ++i)
-	{
-		jctl_graph_entry *e = g->entries + i;
-		if(e->fnlen == fnlen)
-			if(_jctl_strcmp(e->fn, fn) == 0)
-				return 1;
-	}
-	return 0;
-}
-
-
-#ifdef _WIN32
-/*
- * Look for files matching wildcard syntax in the
- * specified directory and register them as new graph entries.
- * By default ignores directory recursion, which can be enabled using the '-r' flag.
- */
-static void jctl_graph_entry_wildcard (ofp_state *S, jctl_graph *g, char *fn, jctl_uint fnlen, jctl_uint dirlen)
-{
-	/*
-	 * Default path for tinydir,
-	 * stays unchanged in case of 'fn'
-	 * being wildcard not including filepath.
-	 */
-	char *dir_path = ".";
-	jctl_uint dir_len = 0;
-
-	/*
-	 * If the wildcard includes a filepath
-	 * (includes the slash '/'),
-	 * separate the directory and wildcard
-	 * for wildcard parser and
-	 * tinydir to open the directory.
-	 */
-	char *lslsh = strrchr(fn, '/'); /* last slash */
-	if(lslsh != NULL)
-	{
-		dir_path = fn;
-		dir_len = lslsh - fn;
-		fnlen -= dir_len + 1;
-		fn = lslsh + 1;
-		/*
-		 * Thanks to tinydir not requiring an "final slash"
-		 * at the end, we can replace the last slash (lslsh)
-		 * with a NULL terminator.
-		 */
-		*lslsh = '\0';
-	}
-
-	/* open directory using tinydir */
-	tinydir_dir dir;
-	tinydir_open(&dir, dir_path);
-
-	while(dir.has_next)
-	{
-		/* get file data */
-		tinydir_file file;
-		tinydir_readfile(&dir, &file);
-
-		/* skip directory */
-		if(file.is_dir)
-		{
-			tinydir_next(&dir);
-			continue;
-		}
-
-		jctl_uint file_len = _jctl_strlen(file.name);
-
-		/* check for wildcard match */
-		if(wc_match(fn, file.name, file_len))
-		{
-			/*
-			 * If graph entry already exists
-			 * (has been included without using wildcard),
-			 * start parsing the next file.
-			 */
-			if(jctl_graph_entry_exists(S, g, file.name, file_len))
-			{
-				tinydir_next(&dir);
-				continue;
-			}
-
-			/*
-			 * Concatenate the directory with filename
-			 * and succesfully register a new graph entry.
-			 */
-			if(lslsh == NULL)
-			{
-				/* no path, just filename */
-				char *file_name = malloc(sizeof(*file_name) * file_len + 1);
-				memcpy(file_name, file.name, file_len + 1);
-				jctl_graph_entry_new(S, g, file_name, file_len, 0, 1);
-			}
-			else
-			{
-				/* path including filename */
-				jctl_uint filename_len = file_len + dir_len + 1;
-				char *file_name = malloc(sizeof(*file_name) * filename_len + 1);
-				memcpy(file_name, dir_path, dir_len);
-				memcpy(file_name + dir_len + 1, file.name, file_len + 1);
-				file_name[dir_len] = '/';
-				jctl_graph_entry_new(S, g, file_name, file_len, dir_len, 1);
-			}
-		}
-
-		tinydir_next(&dir);
-	}
-
-	tinydir_close(&dir);
-}
-#endif /* defined(_WIN32) */
-
-
-/*
- * Register a new graph entry.
- * Wildcards get processed and "highest" values updated.
- */
-static void jctl_graph_entry_new
-(
-	ofp_state *S,		/* OFP state */
-	jctl_graph *g,		/* JCTL graph */
-	char *fp,			/* filepath */
-	jctl_uint fplen,	/* filepath's length */
-	jctl_uint dirlen,	/* directory's lenght */
-	jctl_uint wc		/* wildcard flag */
-)
-{
-	if(g->entrytop >= JCTL_GRAPH_MAX_ENTRIES)
-	{
-		jctl_graph_throw(g);
-	}
-
-#ifdef _WIN32
-	/*
-	 * Command line doesn't handle Wildcards.
-	 * Check for wildcard syntax.
-	 */
-	if(wc_correct(fp))
-	{
-		/*
-		 * 'fp' matches wildcard syntax,
-		 * evaluate the entry as wildcard
-		 * using the 'jctl_graph_entry_wildcard' function.
-		 */
-		jctl_graph_entry_wildcard(S, g, fp, fplen, dirlen);
-		return;
-	}
-	else if(dirlen == 0)
-#else
-	/*
-	 * Wildcard is supported by the command line.
-	 * Every UIA is an filepath.
-	 * Validate that an entry hasn't
-	 * already been registered.
-	 */
-	if(jctl_graph_entry_exists(S, g, fp, fplen))
-	{
-		return;
-	}
-#endif /* defined(_WIN32) */
-	{
-		/*
-		 * Validate that the given filepath
-		 * is not an directory.
-		 */
-		tinydir_dir dir;
-		if(tinydir_open(&dir, fp) == 0)
-		{
-			tinydir_close(&dir);
-			return;
-		}
-
-		/*
-		 * Validate that the given file exists.
-		 */
-		if(!jctl_file_exists(fp))
-		{
-			return;
-		}
-
-		/*
-		 * If non-wildcard argument 
-		 * is a path, not a filename,
-		 * figure out the directory and filename length.
-		 */
-		char *lslsh = strrchr(fp, '/');
-		if(lslsh != NULL)
-		{
-			dirlen = lslsh - fp;
-			fplen -= dirlen + 1;
-		}
-	}
-
-	jctl_graph_entry *e = g->entries + g->entrytop++;
-	e->fn = fp;
-	e->wc = wc;
-
-	/* fnlen */
-	e->fnlen = fplen;
-	if(fplen > g->hfnlen)
-		g->hfnlen = fplen;
-
-	/* lc */
-	jctl_uint lc = jctl_file_linecount(e->fn);
-	e->lc = lc;
-	g->glc += lc;
-
-	/* dirlen */
-	e->dirlen = dirlen;
-	if(dirlen > g->hdirlen)
-		g->hdirlen = dirlen;
-}
-
-
-/*
- * Run a graph for OFP state 'S';
- * Register graph entries and print them sorted by order 'so'.
- *
- * Return 0 if the routine ran successfuly,
- * otherwise return 1.
- */
-jctl_uint jctl_graph_run (ofp_state *S, jctl_graph_sortorder so)
-{
-	jctl_graph *g = (jctl_graph*)malloc(sizeof(*g));
-	if(g == NULL)
-		return 1;
-
-	g->entries = (jctl_graph_entry*)malloc(sizeof(*g->entries) * JCTL_GRAPH_MAX_ENTRIES);
-	if(g->entries == NULL)
-		return 1;
-
-	if(setjmp(g->errbuf))
-		return 1;
-
-	/* initialize members */
-	g->glc = 0;
-	g->hfnlen = 0;
-	g->hdirlen = 0;
-	g->entrytop = 0;
-
-	/*
-	 * Iterate through NAL
-	 * and register graph entries.
-	 */
-	for(ofp_uint i = 0; i < S->nalt; ++i)
-	{
-		char *fn = S->nal[i];
-		if(fn == NULL)
-			continue;
-		jctl_graph_entry_new(S, g, fn, _jctl_strlen(fn), 0, 0);
-	}
-
-	jctl_graph_sort(S, g, so);
-	jctl_graph_print(S, g);
-
-	return 0;
-}
+#include "graph.h"
+#include "file.h"
+#include "pool.h"
+#include "uring.h"
+#include "cache.h"
+#include "set.h"
+#include "jctl.h"
+#include "ofp/state.h"
+#include "dir.h"
+#include "filter.h"
+#include "wildcard.h"
+#include "out.h"
+#include "sort.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+
+static void jctl_graph_entry_new (ofp_state *S, jctl_graph *g, char *fn, jctl_uint fnlen, jctl_uint dirlen, jctl_uint wc);
+static void jctl_graph_dir_release (jctl_graph *g, jctl_graph_dir *d);
+
+/*
+ * Return the length of unsigned integer 'n'.
+ * Used for linecount padding in 'jctl_graph_print'.
+ * Compares against integers, 64-bit counts don't fit a double exactly.
+ */
+static jctl_uint numlen (jctl_size n)
+{
+	if (n < 10ULL)                   return 1;
+	if (n < 100ULL)                  return 2;
+	if (n < 1000ULL)                 return 3;
+	if (n < 10000ULL)                return 4;
+	if (n < 100000ULL)               return 5;
+	if (n < 1000000ULL)              return 6;
+	if (n < 10000000ULL)             return 7;
+	if (n < 100000000ULL)            return 8;
+	if (n < 1000000000ULL)           return 9;
+	if (n < 10000000000ULL)          return 10;
+	if (n < 100000000000ULL)         return 11;
+	if (n < 1000000000000ULL)        return 12;
+	if (n < 10000000000000ULL)       return 13;
+	if (n < 100000000000000ULL)      return 14;
+	if (n < 1000000000000000ULL)     return 15;
+	if (n < 10000000000000000ULL)    return 16;
+	if (n < 100000000000000000ULL)   return 17;
+	if (n < 1000000000000000000ULL)  return 18;
+	if (n < 10000000000000000000ULL) return 19;
+	return 20;
+}
+
+
+/*
+ * Return line count 'lc' as a percentage of the total 'glc'
+ * it is part of, rounded down.
+ * 'lc * 100' would overflow for totals that big,
+ * their hundredth is precise enough then.
+ */
+static inline jctl_uint jctl_graph_percent (jctl_size lc, jctl_size glc)
+{
+	if(glc == 0)
+		return 0;
+	if(glc <= ~0ULL / 100)
+		return (jctl_uint)(lc * 100 / glc);
+
+	jctl_size prc = lc / (glc / 100);
+	return (prc > 100) ? 100 : (jctl_uint) prc;
+}
+
+
+/*
+ * Throw an error for graph 'g'.
+ */
+static inline int jctl_graph_throw (jctl_graph *g)
+{
+	longjmp(g->errbuf, 1);
+}
+
+
+/*
+ * Return the block of the entry store holding entry 'i'.
+ */
+static inline jctl_uint jctl_graph_entry_block (jctl_uint i)
+{
+	jctl_uint q = i / JCTL_GRAPH_ENTRY_BLOCK + 1;
+#if defined(__GNUC__)
+	return 31 - __builtin_clz(q);
+#else
+	jctl_uint b = 0;
+	while(q >>= 1)
+		++b;
+	return b;
+#endif /* defined(__GNUC__) */
+}
+
+
+/*
+ * Return the index past the last entry
+ * of the block holding entry 'i'.
+ */
+static inline jctl_uint jctl_graph_entry_block_end (jctl_uint i)
+{
+	jctl_uint b = jctl_graph_entry_block(i);
+	return JCTL_GRAPH_ENTRY_BLOCK * ((2u << b) - 1);
+}
+
+
+/*
+ * Return entry 'i' of graph 'g'.
+ */
+static inline jctl_graph_entry *jctl_graph_entry_at (jctl_graph *g, jctl_uint i)
+{
+	jctl_uint b = jctl_graph_entry_block(i);
+	return g->blocks[b] + (i - JCTL_GRAPH_ENTRY_BLOCK * ((1u << b) - 1));
+}
+
+
+/*
+ * Reserve 'n' entries of graph 'g', the first one's index goes into '*start'.
+ * The store grows by another block if they don't fit,
+ * entries already stored never move.
+ * Walkers reserve under 'g->lock'.
+ * Return 0 on success, otherwise (out of memory) return 1.
+ */
+static jctl_uint jctl_graph_entry_reserve (jctl_graph *g, jctl_uint n, jctl_uint *start)
+{
+	while(g->entrycap - g->entrytop < n)
+	{
+		if(g->nblocks == JCTL_GRAPH_ENTRY_BLOCKS)
+			return 1;
+
+		size_t size = (size_t) JCTL_GRAPH_ENTRY_BLOCK << g->nblocks;
+		jctl_graph_entry *b = (jctl_graph_entry*)malloc(sizeof(*b) * size);
+		if(b == NULL)
+			return 1;
+
+		g->blocks[g->nblocks++] = b;
+		g->entrycap += size;
+	}
+
+	*start = g->entrytop;
+	g->entrytop += n;
+	return 0;
+}
+
+
+/*
+ * Compare two graph entries by name (alphabetically).
+ * Used in 'jctl_graph_sort'.
+ */
+static inline int jctl_graph_entry_compare_name (const void *a, const void *b)
+{
+	jctl_graph_entry *ea = (jctl_graph_entry*) a;
+	jctl_graph_entry *eb = (jctl_graph_entry*) b;
+	return _jctl_strcmp(ea->fn, eb->fn);
+}
+
+
+/* 
+ * Compare two graph entries by line count (increasing),
+ * equal counts by name.
+ * Used in 'jctl_graph_sort'
+ * Counts are compared rather than subtracted,
+ * their difference doesn't fit an int.
+ */
+static inline int jctl_graph_entry_compare_line_inc (const void *a, const void *b)
+{
+	jctl_graph_entry *ea = (jctl_graph_entry*) a;
+	jctl_graph_entry *eb = (jctl_graph_entry*) b;
+	int c = (ea->lc > eb->lc) - (ea->lc < eb->lc);
+	return (c != 0) ? c : _jctl_strcmp(ea->fn, eb->fn);
+}
+
+
+/*
+ * Compare two graph entries by line count (decreasing),
+ * equal counts by name.
+ * Used in 'jctl_graph_sort'.
+ */
+static inline int jctl_graph_entry_compare_line_dec (const void *a, const void *b)
+{
+	jctl_graph_entry *ea = (jctl_graph_entry*) a;
+	jctl_graph_entry *eb = (jctl_graph_entry*) b;
+	int c = (eb->lc > ea->lc) - (eb->lc < ea->lc);
+	return (c != 0) ? c : _jctl_strcmp(ea->fn, eb->fn);
+}
+
+
+/*
+ * Move the 'n' entries of 'entries' into the order of 'order',
+ * where 'order[k]' is the index of the entry going to 'k'.
+ * Follows the cycles of the permutation with one entry kept aside,
+ * every entry is moved once. 'order' is used up.
+ */
+static void jctl_graph_entry_permute (jctl_graph_entry *entries, jctl_uint *order, jctl_uint n)
+{
+	for(jctl_uint k = 0; k < n; ++k)
+	{
+		if(order[k] == k)
+			continue;
+
+		jctl_graph_entry t = entries[k];
+		jctl_uint j = k;
+		while(order[j] != k)
+		{
+			jctl_uint next = order[j];
+			entries[j] = entries[next];
+			order[j] = j;
+			j = next;
+		}
+		entries[j] = t;
+		order[j] = j;
+	}
+}
+
+
+/*
+ * Sort the 'n' keys of 'keys' of graph 'g' that got sorted by line count
+ * further by name within every run of equal counts, with a multikey
+ * quicksort of the names of the run (see 'jctl_sort_strs').
+ * Return 0 on success, otherwise (out of memory) return 1.
+ */
+static jctl_uint jctl_graph_sort_ties (jctl_graph *g, jctl_sort_key *keys, jctl_uint n)
+{
+	jctl_uint longest = 0;
+	for(jctl_uint a = 0, b; a < n; a = b)
+	{
+		b = a + 1;
+		while(b < n && keys[b].key == keys[a].key)
+			++b;
+		if(b - a > longest)
+			longest = b - a;
+	}
+
+	if(longest < 2)
+		return 0;
+
+	jctl_sort_str *strs = (jctl_sort_str*)malloc(sizeof(*strs) * longest);
+	if(strs == NULL)
+		return 1;
+
+	for(jctl_uint a = 0, b; a < n; a = b)
+	{
+		b = a + 1;
+		while(b < n && keys[b].key == keys[a].key)
+			++b;
+		if(b - a < 2)
+			continue;
+
+		for(jctl_uint k = a; k < b; ++k)
+		{
+			strs[k - a].s = g->entries[keys[k].i].fn;
+			strs[k - a].i = keys[k].i;
+		}
+		jctl_sort_strs(strs, b - a);
+		for(jctl_uint k = a; k < b; ++k)
+			keys[k].i = strs[k - a].i;
+	}
+
+	free(strs);
+	return 0;
+}
+
+
+/*
+ * Sort graph entries of graph 'g' by line count, decreasing if 'dec',
+ * with a radix sort of their counts (see 'jctl_sort_keys').
+ * Equal counts are ordered by name, the entries are registered
+ * in whatever order the walkers find them.
+ * Return 0 on success, otherwise (out of memory) return 1.
+ */
+static jctl_uint jctl_graph_sort_lines (jctl_graph *g, jctl_uint dec)
+{
+	jctl_sort_key *keys = (jctl_sort_key*)malloc(sizeof(*keys) * g->entrytop);
+	if(keys == NULL)
+		return 1;
+
+	for(jctl_uint i = 0; i < g->entrytop; ++i)
+	{
+		keys[i].key = dec ? ~g->entries[i].lc : g->entries[i].lc;
+		keys[i].i = i;
+	}
+
+	if(jctl_sort_keys(keys, g->entrytop) || jctl_graph_sort_ties(g, keys, g->entrytop))
+	{
+		free(keys);
+		return 1;
+	}
+
+	/* the order goes into the keys, they are twice as big */
+	jctl_uint *order = (jctl_uint*) keys;
+	for(jctl_uint i = 0; i < g->entrytop; ++i)
+		order[i] = keys[i].i;
+
+	jctl_graph_entry_permute(g->entries, order, g->entrytop);
+	free(keys);
+	return 0;
+}
+
+
+/*
+ * Sort graph entries of graph 'g' by name,
+ * with a multikey quicksort of their names (see 'jctl_sort_strs').
+ * Return 0 on success, otherwise (out of memory) return 1.
+ */
+static jctl_uint jctl_graph_sort_names (jctl_graph *g)
+{
+	jctl_sort_str *strs = (jctl_sort_str*)malloc(sizeof(*strs) * g->entrytop);
+	if(strs == NULL)
+		return 1;
+
+	for(jctl_uint i = 0; i < g->entrytop; ++i)
+	{
+		strs[i].s = g->entries[i].fn;
+		strs[i].i = i;
+	}
+
+	jctl_sort_strs(strs, g->entrytop);
+
+	jctl_uint *order = (jctl_uint*) strs;
+	for(jctl_uint i = 0; i < g->entrytop; ++i)
+		order[i] = strs[i].i;
+
+	jctl_graph_entry_permute(g->entries, order, g->entrytop);
+	free(strs);
+	return 0;
+}
+
+
+/*
+ * Sort graph entries given the sort order 'so' and graph 'g'.
+ * Only the keys get sorted, the entries are moved once afterwards.
+ * Falls back to the standard C quick sort implementation 'qsort'
+ * if the keys can't be allocated.
+ */
+static void jctl_graph_sort (ofp_state *S, jctl_graph *g, jctl_graph_sortorder so)
+{
+	switch(so)
+	{
+	case JCTL_GRAPH_SORT_NAME:
+		if(jctl_graph_sort_names(g))
+			_jctl_graph_sort(g->entries, g->entrytop, sizeof(*g->entries), jctl_graph_entry_compare_name);
+		break;
+	case JCTL_GRAPH_SORT_LINE_INC:
+		if(jctl_graph_sort_lines(g, 0))
+			_jctl_graph_sort(g->entries, g->entrytop, sizeof(*g->entries), jctl_graph_entry_compare_line_inc);
+		break;
+	case JCTL_GRAPH_SORT_LINE_DEC:
+		if(jctl_graph_sort_lines(g, 1))
+			_jctl_graph_sort(g->entries, g->entrytop, sizeof(*g->entries), jctl_graph_entry_compare_line_dec);
+		break;
+	}
+}
+
+
+/*
+ * Add the unit "line" or "lines" for line count 'lc'
+ * to the output of writer 'o', padded to the same width with 'pad'.
+ */
+static inline void jctl_graph_print_unit (jctl_out *o, jctl_size lc, jctl_uint pad)
+{
+	if(lc == 1)
+		jctl_out_write(o, pad ? " line " : " line", pad ? 6 : 5);
+	else
+		jctl_out_write(o, " lines", 6);
+}
+
+
+/* 
+ * Print the graph 'g' with writer 'o'.
+ * Includes padding for more readibilty.
+ */
+static void jctl_graph_print (ofp_state *S, jctl_graph *g, jctl_out *o)
+{
+	/*
+	 * No need to keep track of
+	 * the highest line count length.
+	 * The global line count will always
+	 * be the highest, so calculate
+	 * it's numeric length.
+	 */
+	jctl_uint hlclen = numlen(g->glc);
+
+	/*
+	 * Flag that specifies if
+	 * the slash should be taken
+	 * into account in entry padding.
+	 */
+	int incslsh = (g->hdirlen != 0);
+
+	/*
+	 * Iterate through graph entries
+	 * and add their data to the output
+	 * of the writer including the padding.
+	 */
+	for(jctl_uint i = 0; i < g->entrytop; ++i)
+	{
+		jctl_graph_entry *e = g->entries + i;
+
+		/*
+		 * Flag that specifies if
+		 * the file resides in
+		 * executable's directory.
+		 */
+		int exedir = (e->dirlen == 0);
+
+		/* "directory" padding */
+		jctl_out_fill(o, ' ', g->hdirlen - e->dirlen + incslsh * exedir);
+
+		/* filename */
+		jctl_out_write(o, e->fn, _jctl_strlen(e->fn));
+
+		/* "post-filename" padding */
+		jctl_out_fill(o, ' ', g->hfnlen - e->fnlen);
+		jctl_out_write(o, " | ", 3);
+
+		/* line count */
+		jctl_out_uint(o, e->lc);
+		jctl_out_fill(o, ' ', hlclen - numlen(e->lc));
+		jctl_graph_print_unit(o, e->lc, 1);
+		jctl_out_write(o, " [", 2);
+
+		/* graph */
+		jctl_uint prc = jctl_graph_percent(e->lc, g->glc);
+		jctl_uint bars = prc * JCTL_GRAPH_BARS / 100;
+		jctl_out_fill(o, '=', bars);
+		jctl_out_fill(o, ' ', JCTL_GRAPH_BARS - bars);
+
+		/* percentage */
+		jctl_out_write(o, "] ", 2);
+		jctl_out_uint(o, prc);
+		jctl_out_write(o, "%\n", 2);
+	}
+
+	/* global line count */
+	jctl_out_fill(o, ' ', g->hfnlen + g->hdirlen + incslsh + 3);
+	jctl_out_uint(o, g->glc);
+	jctl_graph_print_unit(o, g->glc, 0);
+	jctl_out_write(o, "\n", 1);
+}
+
+
+/*
+ * Add the records of the entries of graph 'g' to writer 'o',
+ * in the output format of '--format'.
+ */
+static void jctl_graph_emit (jctl_graph *g, jctl_out *o)
+{
+	for(jctl_uint i = 0; i < g->entrytop; ++i)
+	{
+		jctl_graph_entry *e = g->entries + i;
+		jctl_emit_entry(o, g->format, e->fn, _jctl_strlen(e->fn), e->lc, e->fi.size, e->dirlen);
+	}
+}
+
+
+/*
+ * Save the entries of graph 'g' as snapshot file 'fn',
+ * sorting them by name first.
+ * Return 0 on success, otherwise (the file can't be written) return 1.
+ */
+static jctl_uint jctl_graph_snapshot (ofp_state *S, jctl_graph *g, const char *fn)
+{
+	jctl_snap_writer w;
+	if(jctl_snap_create(&w, fn))
+		return 1;
+
+	jctl_graph_sort(S, g, JCTL_GRAPH_SORT_NAME);
+	for(jctl_uint i = 0; i < g->entrytop; ++i)
+	{
+		jctl_graph_entry *e = g->entries + i;
+		jctl_snap_add(&w, e->fn, _jctl_strlen(e->fn), e->lc, e->fi.size, e->dirlen);
+	}
+
+	return jctl_snap_finish(&w);
+}
+
+
+/*
+ * Print roll-up 'r' of graph 'g' with writer 'o' like its files,
+ * a line per key, sorted by order 'so'.
+ * The entries of the graph are left as they were.
+ * Return 0 on success, otherwise (out of memory) return 1.
+ */
+static jctl_uint jctl_graph_print_rollup (ofp_state *S, jctl_graph *g, jctl_rollup *r, jctl_graph_sortorder so, jctl_out *o)
+{
+	jctl_graph_entry *entries = g->entries;
+	jctl_uint entrytop = g->entrytop;
+	jctl_uint hfnlen = g->hfnlen;
+	jctl_uint hdirlen = g->hdirlen;
+
+	g->entries = (jctl_graph_entry*)calloc(r->count + 1, sizeof(*g->entries));
+	if(g->entries == NULL)
+	{
+		g->entries = entries;
+		return 1;
+	}
+
+	/* keys are printed as names without a directory */
+	g->entrytop = 0;
+	g->hfnlen = 0;
+	g->hdirlen = 0;
+	for(size_t i = 0; i < r->cap; ++i)
+	{
+		jctl_rollup_slot *sl = r->slots + i;
+		if(sl->key == NULL)
+			continue;
+
+		jctl_graph_entry *e = g->entries + g->entrytop++;
+		e->fn = (char*) sl->key;
+		e->fnlen = sl->len;
+		e->lc = sl->lines;
+		if(e->fnlen > g->hfnlen)
+			g->hfnlen = e->fnlen;
+	}
+
+	/* keys of equal lines by name, the line sorts keep their order */
+	jctl_graph_sort(S, g, JCTL_GRAPH_SORT_NAME);
+	if(so != JCTL_GRAPH_SORT_NAME)
+		jctl_graph_sort(S, g, so);
+	jctl_graph_print(S, g, o);
+
+	free(g->entries);
+	g->entries = entries;
+	g->entrytop = entrytop;
+	g->hfnlen = hfnlen;
+	g->hdirlen = hdirlen;
+	return 0;
+}
+
+
+/*
+ * Register file 'fp' of information 'fi' in the file set of graph 'g',
+ * by device and inode, so hard links and different spellings
+ * of the same file are counted once.
+ * Files without inodes are told apart by their path.
+ * Unless 'g->remember' is set, the file is only looked up.
+ * Return 1 if it wasn't registered before
+ * (or the set ran out of memory), otherwise return 0.
+ */
+static int jctl_graph_file_new (jctl_graph *g, jctl_file_info *fi, const char *fp)
+{
+	jctl_size dev = fi->dev;
+	jctl_size ino = fi->ino;
+
+	if(ino == 0)
+	{
+		dev = ~0ULL;
+		ino = 14695981039346656037ULL;
+		for(const char *p = fp; *p != '\0'; ++p)
+			ino = (ino ^ (unsigned char) *p) * 1099511628211ULL;
+		ino |= 1;
+	}
+
+	if(!g->remember)
+		return !jctl_set_shared_contains(&g->files, dev, ino);
+
+	return (jctl_set_shared_insert(&g->files, dev, ino) != 0);
+}
+
+
+/*
+ * Allocate 'n' bytes for a path found by worker 'w' of graph 'g'.
+ * Paths stay in the worker's arena until the run ends,
+ * unless entries get dropped once counted ('g->drop'),
+ * then they are malloc'ed and freed once done with.
+ */
+static inline char *jctl_graph_path_new (jctl_graph *g, jctl_graph_worker *w, size_t n)
+{
+	if(g->drop)
+		return (char*)malloc(n);
+	return (char*)jctl_arena_alloc(&w->names, n);
+}
+
+
+/*
+ * Drop path 'fp' of graph 'g' allocated by 'jctl_graph_path_new'.
+ */
+static inline void jctl_graph_path_free (jctl_graph *g, char *fp)
+{
+	if(g->drop)
+		free(fp);
+}
+
+
+/*
+ * Widen column 'width' shared by all counting threads
+ * to at least 'n' characters, it never gets narrower.
+ * Return the width to print with.
+ */
+static inline jctl_uint jctl_graph_stream_widen (atomic_uint *width, jctl_uint n)
+{
+	jctl_uint cur = atomic_load(width);
+	while(cur < n && !atomic_compare_exchange_weak(width, &cur, n))
+		;
+	return (cur > n) ? cur : n;
+}
+
+
+/*
+ * Add the line of counted entry 'e' to the output of worker 'w',
+ * or its record in the output format of '--format'.
+ * Without the total there are no bars and percentages,
+ * the columns are as wide as the widest name and
+ * line count printed so far.
+ * The whole line is reserved at once, so it's written at once.
+ */
+static void jctl_graph_stream_entry (jctl_graph_worker *w, jctl_graph_entry *e)
+{
+	jctl_graph *g = w->g;
+	jctl_uint fplen = _jctl_strlen(e->fn);
+
+	if(g->format != JCTL_EMIT_TEXT)
+	{
+		jctl_emit_entry(&w->out, g->format, e->fn, fplen, e->lc, e->fi.size, e->dirlen);
+		return;
+	}
+
+	jctl_uint lclen = numlen(e->lc);
+	jctl_uint fpwidth = jctl_graph_stream_widen(&g->streamfn, fplen);
+	jctl_uint lcwidth = jctl_graph_stream_widen(&g->streamlc, lclen);
+
+	/* " | " and " lines\n" around the columns */
+	if(jctl_out_reserve(&w->out, fpwidth + lcwidth + 10))
+		return;
+
+	jctl_out_write(&w->out, e->fn, fplen);
+	jctl_out_fill(&w->out, ' ', fpwidth - fplen);
+	jctl_out_write(&w->out, " | ", 3);
+	jctl_out_uint(&w->out, e->lc);
+	jctl_out_fill(&w->out, ' ', lcwidth - lclen);
+	jctl_graph_print_unit(&w->out, e->lc, 0);
+	jctl_out_write(&w->out, "\n", 1);
+}
+
+
+/*
+ * Print the total line count of graph 'g' after its streamed files
+ * with writer 'o', below their line counts.
+ */
+static void jctl_graph_stream_total (jctl_graph *g, jctl_out *o)
+{
+	jctl_out_fill(o, ' ', atomic_load(&g->streamfn) + 3);
+	jctl_out_uint(o, g->glc);
+	jctl_graph_print_unit(o, g->glc, 0);
+	jctl_out_write(o, "\n", 1);
+}
+
+
+/*
+ * Compare graph entries 'a' and 'b' in sort order 'so',
+ * like 'jctl_graph_sort' orders them.
+ * Equal line counts are told apart by name, so which
+ * entries '--top' keeps doesn't depend on the counting threads.
+ */
+static int jctl_graph_entry_compare (jctl_graph_sortorder so, jctl_graph_entry *a, jctl_graph_entry *b)
+{
+	if(so == JCTL_GRAPH_SORT_LINE_INC)
+		return jctl_graph_entry_compare_line_inc(a, b);
+	if(so == JCTL_GRAPH_SORT_LINE_DEC)
+		return jctl_graph_entry_compare_line_dec(a, b);
+	return jctl_graph_entry_compare_name(a, b);
+}
+
+
+/*
+ * Drop counted entry 'e' of graph 'g', freeing the path
+ * of a file found by a walker or glob.
+ */
+static inline void jctl_graph_entry_drop (jctl_graph *g, jctl_graph_entry *e)
+{
+	if(e->wc)
+		jctl_graph_path_free(g, e->fn);
+}
+
+
+/*
+ * Offer counted entry 'e' to heap 'h' of graph 'g', holding '*n' entries.
+ *
+ * The heap keeps the first 'g->top' entries in sort order 'g->keep',
+ * the one sorting last at its root, to be replaced by any entry
+ * sorting before it. The heap takes over the path of 'e',
+ * dropping it with the entry if that isn't kept.
+ */
+static void jctl_graph_heap_push (jctl_graph *g, jctl_graph_entry *h, jctl_uint *n, jctl_graph_entry *e)
+{
+	jctl_uint i;
+
+	if(*n < g->top)
+	{
+		/* sift up from the new leaf */
+		i = (*n)++;
+		while(i > 0 && jctl_graph_entry_compare(g->keep, e, h + (i - 1) / 2) > 0)
+		{
+			h[i] = h[(i - 1) / 2];
+			i = (i - 1) / 2;
+		}
+	}
+	else
+	{
+		if(jctl_graph_entry_compare(g->keep, e, h) >= 0)
+		{
+			jctl_graph_entry_drop(g, e);
+			return;
+		}
+		jctl_graph_entry_drop(g, h);
+
+		/* sift down from the root */
+		i = 0;
+		for(;;)
+		{
+			jctl_uint c = 2 * i + 1;
+			if(c >= *n)
+				break;
+			if(c + 1 < *n && jctl_graph_entry_compare(g->keep, h + c + 1, h + c) > 0)
+				++c;
+			if(jctl_graph_entry_compare(g->keep, h + c, e) <= 0)
+				break;
+			h[i] = h[c];
+			i = c;
+		}
+	}
+
+	h[i] = *e;
+	/* only needed while counting */
+	h[i].dir = NULL;
+}
+
+
+/*
+ * Register wildcard 'fp' of graph 'g' as a glob,
+ * expanded by 'jctl_graph_glob_start' once counting starts.
+ * Its segments get compiled once here,
+ * instead of parsing them again for every name.
+ * A trailing "**" matches every file below its directory.
+ * Return the glob, or NULL if out of memory.
+ */
+static jctl_graph_glob *jctl_graph_glob_new (jctl_graph *g, char *fp, jctl_uint fplen)
+{
+	/* names of file lists come on top of the command line */
+	if(g->globtop == g->globcap)
+	{
+		jctl_graph_glob **globs = (jctl_graph_glob**)realloc(g->globs, sizeof(*globs) * g->globcap * 2);
+		if(globs == NULL)
+			return NULL;
+		g->globs = globs;
+		g->globcap *= 2;
+	}
+
+	jctl_graph_glob *gl = (jctl_graph_glob*)calloc(1, sizeof(*gl));
+	if(gl == NULL)
+		return NULL;
+	g->globs[g->globtop++] = gl;
+
+	gl->buf = (char*)malloc(fplen + 1);
+	gl->segs = (jctl_graph_glob_seg*)calloc(fplen / 2 + 2, sizeof(*gl->segs));
+	if(gl->buf == NULL || gl->segs == NULL)
+		return NULL;
+	memcpy(gl->buf, fp, fplen + 1);
+	gl->absolute = (fp[0] == '/');
+
+	for(char *p = strtok(gl->buf, "/"); p != NULL; p = strtok(NULL, "/"))
+	{
+		jctl_graph_glob_kind kind = JCTL_GRAPH_GLOB_LITERAL;
+		if(strcmp(p, "**") == 0)
+			kind = JCTL_GRAPH_GLOB_ANY;
+		else if(wc_correct(p))
+			kind = JCTL_GRAPH_GLOB_WILD;
+
+		/* consecutive "**" segments are the same as one */
+		if(kind == JCTL_GRAPH_GLOB_ANY && gl->n > 0 && gl->segs[gl->n - 1].kind == JCTL_GRAPH_GLOB_ANY)
+			continue;
+
+		jctl_graph_glob_seg *seg = gl->segs + gl->n++;
+		seg->s = p;
+		seg->kind = kind;
+	}
+
+	if(gl->n > 0 && gl->segs[gl->n - 1].kind == JCTL_GRAPH_GLOB_ANY)
+	{
+		jctl_graph_glob_seg *seg = gl->segs + gl->n++;
+		seg->s = "*";
+		seg->kind = JCTL_GRAPH_GLOB_WILD;
+	}
+
+	for(jctl_uint i = 0; i < gl->n; ++i)
+	{
+		jctl_graph_glob_seg *seg = gl->segs + i;
+		seg->hidden = (seg->s[0] == '.');
+		if(seg->kind == JCTL_GRAPH_GLOB_WILD && wc_compile(&seg->dfa, seg->s))
+			return NULL;
+	}
+
+	return gl;
+}
+
+
+/*
+ * Free glob 'gl'.
+ */
+static void jctl_graph_glob_free (jctl_graph_glob *gl)
+{
+	if(gl == NULL)
+		return;
+	for(jctl_uint i = 0; gl->segs != NULL && i < gl->n; ++i)
+		if(gl->segs[i].kind == JCTL_GRAPH_GLOB_WILD)
+			wc_free(&gl->segs[i].dfa);
+	free(gl->segs);
+	free(gl->buf);
+	free(gl);
+}
+
+
+/*
+ * Initialize graph entry 'e' of graph 'g' for file 'fp'
+ * of information 'fi'.
+ * The entry gets counted later by the thread pool,
+ * unless the cache knows it unchanged.
+ */
+static void jctl_graph_entry_init (jctl_graph *g, jctl_graph_entry *e, char *fp, jctl_uint fplen, jctl_uint dirlen, jctl_uint wc, jctl_file_info *fi)
+{
+	e->fn = fp;
+	e->wc = wc;
+	e->lc = 0;
+	e->fnlen = fplen;
+	e->dirlen = dirlen;
+	e->skip = 0;
+	e->split = 0;
+	e->tail.size = 0;
+	e->dir = NULL;
+	e->cached = (g->cache != NULL && jctl_cache_lookup(g->cache, fi, &e->lc, &e->tail));
+	e->fi = *fi;
+}
+
+
+/*
+ * Register a new graph entry.
+ * Wildcards get processed and "highest" values updated.
+ */
+static void jctl_graph_entry_new
+(
+	ofp_state *S,		/* OFP state */
+	jctl_graph *g,		/* JCTL graph */
+	char *fp,			/* filepath */
+	jctl_uint fplen,	/* filepath's length */
+	jctl_uint dirlen,	/* directory's lenght */
+	jctl_uint wc		/* wildcard flag */
+)
+{
+	jctl_file_info fi;
+	memset(&fi, 0, sizeof(fi));
+
+	/*
+	 * Wildcards get expanded by jctl itself,
+	 * the shell may not have (quoted, or no shell at all)
+	 * and large expansions don't fit the command line.
+	 * A file or directory of that very name is taken as it is.
+	 */
+	if(wc_correct(fp) && jctl_file_stat(fp, &fi) && jctl_dir_stat(fp, &fi))
+	{
+		if(jctl_graph_glob_new(g, fp, fplen) == NULL)
+			jctl_graph_throw(g);
+		return;
+	}
+
+	{
+		/*
+		 * Skip files whose name doesn't pass
+		 * the include and exclude patterns.
+		 */
+		char *lslsh = strrchr(fp, '/');
+		char *name = (lslsh != NULL) ? lslsh + 1 : fp;
+		if(g->filter != NULL && !jctl_filter_match(g->filter, name, fplen - (name - fp)))
+		{
+			return;
+		}
+
+		/*
+		 * Validate that the given file exists
+		 * and is not an directory.
+		 */
+		if(jctl_file_stat(fp, &fi))
+		{
+			return;
+		}
+
+		/*
+		 * Validate that an entry hasn't
+		 * already been registered.
+		 */
+		if(!jctl_graph_file_new(g, &fi, fp))
+		{
+			return;
+		}
+
+		/*
+		 * If non-wildcard argument 
+		 * is a path, not a filename,
+		 * figure out the directory and filename length.
+		 */
+		if(lslsh != NULL)
+		{
+			dirlen = lslsh - fp;
+			fplen -= dirlen + 1;
+		}
+	}
+
+	jctl_uint i;
+	if(jctl_graph_entry_reserve(g, 1, &i))
+	{
+		jctl_graph_throw(g);
+	}
+
+	jctl_graph_entry_init(g, jctl_graph_entry_at(g, i), fp, fplen, dirlen, wc, &fi);
+}
+
+
+#if JCTL_GRAPH_CHUNK > JCTL_URING_SLOTS
+	#error "a graph chunk has to fit into one io_uring batch"
+#endif
+
+/*
+ * Count the small regular files among the 'n' graph entries
+ * 'entries' with the io_uring backend of worker 'w'.
+ * Sets 'done[k]' for every entry 'k' that got counted.
+ */
+static void jctl_graph_count_uring (jctl_graph_worker *w, jctl_graph_entry *entries, size_t n, jctl_uint *done)
+{
+	char *fn[JCTL_URING_SLOTS];
+	jctl_size size[JCTL_URING_SLOTS];
+	jctl_uint idx[JCTL_URING_SLOTS];
+	jctl_size lc[JCTL_URING_SLOTS];
+	jctl_uint err[JCTL_URING_SLOTS];
+	jctl_uint count = 0;
+
+	for(size_t k = 0; k < n; ++k)
+	{
+		jctl_graph_entry *e = entries + k;
+		if(e->split || e->cached || !e->fi.reg || e->fi.size >= JCTL_URING_SLOT)
+			continue;
+		fn[count] = e->fn;
+		/* walkers that don't stat know no sizes */
+		size[count] = w->g->stat ? e->fi.size : JCTL_FILE_EOF;
+		idx[count] = (jctl_uint) k;
+		++count;
+	}
+
+	if(count == 0)
+		return;
+
+	jctl_uring_linecount(w->uring, fn, size, count, lc, err);
+
+	for(jctl_uint k = 0; k < count; ++k)
+	{
+		if(err[k])
+			continue;
+		/* counted whole, without a tail */
+		entries[idx[k]].lc = lc[k];
+		entries[idx[k]].tail.size = 0;
+		done[idx[k]] = 1;
+	}
+}
+
+
+/*
+ * Sum up the lines of counted entry 'e' in the roll-ups of worker 'w',
+ * under its directory for '--by-dir' and its extension for '--by-ext'.
+ * The directory of a file of the working directory is ".",
+ * with '--by-dir=N' only its first N levels count.
+ * The extension starts at the last dot of the name like
+ * for '--include', names without one go under "(none)".
+ */
+static void jctl_graph_rollup_add (jctl_graph_worker *w, jctl_graph_entry *e)
+{
+	jctl_graph *g = w->g;
+	jctl_uint err = 0;
+
+	if(g->bydir)
+	{
+		size_t len;
+		const char *dir = jctl_rollup_dir(e->fn, e->dirlen, g->dirdepth, &len);
+		err |= jctl_rollup_add(&w->rdirs, dir, len, e->lc);
+	}
+
+	if(g->byext)
+	{
+		/* "/name" has its directory length at 0 too */
+		const char *name = e->fn + e->dirlen + (e->dirlen > 0 || e->fn[0] == '/');
+		size_t len = e->fnlen;
+		size_t dot = len;
+		while(dot > 0 && name[dot - 1] != '.')
+			--dot;
+		if(dot > 0)
+			err |= jctl_rollup_add(&w->rexts, name + dot - 1, len - dot + 1, e->lc);
+		else
+			err |= jctl_rollup_add(&w->rexts, "(none)", 6, e->lc);
+	}
+
+	if(err)
+		atomic_store(&g->overflow, 1);
+}
+
+
+/*
+ * Pool task counting the chunk of 'n' (at most JCTL_GRAPH_CHUNK)
+ * graph entries starting at entry 'arg'.
+ * Totals go to the worker's own 'jctl_graph_worker',
+ * with '--stream' the counted entries get printed right away,
+ * with '--top' they go to the worker's heap,
+ * with '--by-dir' and '--by-ext' they get summed up in its roll-ups.
+ */
+static void jctl_graph_count_chunk (jctl_pool_worker *pw, void *arg, size_t n)
+{
+	jctl_graph_entry *entries = (jctl_graph_entry*) arg;
+	jctl_graph_worker *w = (jctl_graph_worker*) pw->ud;
+	jctl_graph *g = w->g;
+
+	/*
+	 * Small files go through io_uring as one batch first,
+	 * whatever it couldn't count is read the usual way.
+	 */
+	jctl_uint done[JCTL_GRAPH_CHUNK] = {0};
+	if(w->uring != NULL)
+		jctl_graph_count_uring(w, entries, n, done);
+
+	for(size_t k = 0; k < n; ++k)
+	{
+		jctl_graph_entry *e = entries + k;
+
+		/*
+		 * Split entries are counted
+		 * by 'jctl_graph_count_range'.
+		 */
+		if(e->split)
+			continue;
+
+		/*
+		 * With the cache, counting goes on from the tail
+		 * of the cached count of files that got appended to.
+		 */
+		jctl_uint err = 0;
+		if(!done[k] && !e->cached)
+		{
+			/* walked files are opened relative to their directory */
+			int dirfd = (e->dir != NULL) ? e->dir->fd : -1;
+			char *fn = (e->dir != NULL) ? e->fn + e->dirlen + 1 : e->fn;
+			err = jctl_file_linecount_at(&w->buf, dirfd, fn, (g->cache != NULL) ? &e->tail : NULL, &e->lc);
+		}
+
+		/*
+		 * Skip files that can't be read.
+		 */
+		if(err)
+		{
+			e->skip = 1;
+			continue;
+		}
+
+		w->glc += e->lc;
+		if(e->fnlen > w->hfnlen)
+			w->hfnlen = e->fnlen;
+		if(e->dirlen > w->hdirlen)
+			w->hdirlen = e->dirlen;
+
+		if(g->bydir || g->byext)
+			jctl_graph_rollup_add(w, e);
+
+		if(g->stream)
+			jctl_graph_stream_entry(w, e);
+		else if(g->top > 0)
+			jctl_graph_heap_push(g, w->heap, &w->heaptop, e);
+	}
+
+	if(g->stream)
+		jctl_out_flush(&w->out);
+
+	/* chunks of walked files hold their directory open */
+	if(n > 0 && entries[0].dir != NULL)
+		jctl_graph_dir_release(g, entries[0].dir);
+}
+
+
+/*
+ * Keep the file descriptor 'fd' of a walked directory open
+ * for counting its files relative to it.
+ * Return the shared directory holding the walker's reference,
+ * or NULL if 'fd' is -1 or too many are open already,
+ * the files then get opened by their path.
+ */
+static jctl_graph_dir *jctl_graph_dir_new (jctl_graph *g, int fd)
+{
+	if(fd < 0)
+		return NULL;
+
+	if(atomic_fetch_add(&g->dirsopen, 1) >= JCTL_GRAPH_DIRS_OPEN)
+	{
+		atomic_fetch_sub(&g->dirsopen, 1);
+		return NULL;
+	}
+
+	jctl_graph_dir *d = (jctl_graph_dir*)malloc(sizeof(*d));
+	if(d == NULL)
+	{
+		atomic_fetch_sub(&g->dirsopen, 1);
+		return NULL;
+	}
+
+	d->fd = fd;
+	atomic_init(&d->refs, 1);
+	return d;
+}
+
+
+/*
+ * Drop a reference to shared directory 'd' of graph 'g',
+ * the last one closes it.
+ */
+static void jctl_graph_dir_release (jctl_graph *g, jctl_graph_dir *d)
+{
+	if(atomic_fetch_sub(&d->refs, 1) != 1)
+		return;
+
+	jctl_dir_fd_close(d->fd);
+	free(d);
+	atomic_fetch_sub(&g->dirsopen, 1);
+}
+
+
+/*
+ * Pool task counting the chunk of 'n' entries 'arg' that get dropped,
+ * a malloc'ed copy of a walker's batch, freed with their paths
+ * once printed or offered to the heap of '--top'.
+ */
+static void jctl_graph_count_copy (jctl_pool_worker *pw, void *arg, size_t n)
+{
+	jctl_graph_entry *entries = (jctl_graph_entry*) arg;
+	jctl_graph_worker *w = (jctl_graph_worker*) pw->ud;
+	jctl_graph *g = w->g;
+
+	jctl_graph_count_chunk(pw, arg, n);
+
+	if(g->cache != NULL)
+	{
+		pthread_mutex_lock(&g->lock);
+		for(size_t k = 0; k < n; ++k)
+			if(!entries[k].skip && !entries[k].cached)
+				jctl_cache_put(g->cache, &entries[k].fi, entries[k].lc, &entries[k].tail);
+		pthread_mutex_unlock(&g->lock);
+	}
+
+	/* the heap took over the paths of the counted ones */
+	for(size_t k = 0; k < n; ++k)
+		if(g->top == 0 || entries[k].skip)
+			free(entries[k].fn);
+	free(entries);
+}
+
+
+/*
+ * Register the 'n' entries of 'batch' found by a walker
+ * as graph entries of graph 'g', and submit them
+ * to be counted to the deque of worker 'pw'.
+ * If entries get dropped once counted they are counted from a copy instead.
+ * If the entry store can't grow, they are dropped and set 'g->overflow'.
+ */
+static void jctl_graph_walk_push (jctl_pool_worker *pw, jctl_graph *g, jctl_graph_entry *batch, jctl_uint n)
+{
+	if(n == 0)
+		return;
+
+	if(g->drop)
+	{
+		jctl_graph_entry *c = (jctl_graph_entry*)malloc(sizeof(*c) * n);
+		if(c == NULL)
+		{
+			for(jctl_uint k = 0; k < n; ++k)
+				free(batch[k].fn);
+			atomic_store(&g->overflow, 1);
+			return;
+		}
+
+		/* the chunk releases it once counted */
+		if(batch[0].dir != NULL)
+			atomic_fetch_add(&batch[0].dir->refs, 1);
+
+		memcpy(c, batch, sizeof(*batch) * n);
+		jctl_pool_submit(pw->pool, pw, jctl_graph_count_copy, c, n);
+		return;
+	}
+
+	pthread_mutex_lock(&g->lock);
+	jctl_uint start;
+	jctl_uint err = jctl_graph_entry_reserve(g, n, &start);
+	pthread_mutex_unlock(&g->lock);
+
+	if(err)
+	{
+		atomic_store(&g->overflow, 1);
+		return;
+	}
+
+	/* a batch spanning two blocks is counted as two chunks */
+	for(jctl_uint k = 0; k < n;)
+	{
+		jctl_uint end = jctl_graph_entry_block_end(start + k);
+		jctl_uint run = (end - (start + k) < n - k) ? end - (start + k) : n - k;
+		jctl_graph_entry *e = jctl_graph_entry_at(g, start + k);
+
+		/* the chunk releases it once counted */
+		if(batch[k].dir != NULL)
+			atomic_fetch_add(&batch[k].dir->refs, 1);
+
+		memcpy(e, batch + k, sizeof(*batch) * run);
+		jctl_pool_submit(pw->pool, pw, jctl_graph_count_chunk, e, run);
+		k += run;
+	}
+}
+
+
+/*
+ * Mark directory 'path' of graph 'g' as walked,
+ * 'path' is relative to directory 'dirfd' (-1 for none).
+ * Return 1 if it is a directory not walked before,
+ * otherwise return 0.
+ * Directories reached twice, by bind mounts or by being
+ * named twice, are only walked once.
+ */
+static int jctl_graph_walk_visit (jctl_graph *g, int dirfd, char *path)
+{
+	jctl_file_info fi;
+	if(jctl_dir_stat_at(dirfd, path, &fi))
+		return 0;
+
+	/* no inodes to tell directories apart */
+	if(fi.ino == 0)
+		return 1;
+
+	pthread_mutex_lock(&g->lock);
+	int first = jctl_set_insert(&g->dirs, fi.dev, fi.ino);
+	pthread_mutex_unlock(&g->lock);
+
+	return (first == 1);
+}
+
+
+/*
+ * Write path 'path' of length 'len' joined with name 'name'
+ * of length 'namelen' into 'out', which has room for both,
+ * a separator and the terminator. Return the length written.
+ * The working directory "" and the root directory "/"
+ * need no separator.
+ */
+static size_t jctl_graph_glob_join (char *out, const char *path, size_t len, const char *name, size_t namelen)
+{
+	jctl_uint sep = (len > 0 && path[len - 1] != '/');
+	if(out != path)
+		memcpy(out, path, len);
+	if(sep)
+		out[len] = '/';
+	memcpy(out + len + sep, name, namelen);
+	out[len + sep + namelen] = '\0';
+	return len + sep + namelen;
+}
+
+
+/*
+ * Return a task walking directory 'path' of length 'len'
+ * joined with 'name' of length 'namelen' unless it is 0,
+ * under the ignore rules 'ign' (referenced once more),
+ * or NULL if out of memory.
+ */
+static jctl_graph_walk_task *jctl_graph_walk_task_new (jctl_graph *g, jctl_ignore *ign, const char *path, size_t len, const char *name, size_t namelen)
+{
+	jctl_graph_walk_task *t = (jctl_graph_walk_task*)malloc(sizeof(*t) + len + namelen + 2);
+	if(t == NULL)
+	{
+		atomic_store(&g->overflow, 1);
+		return NULL;
+	}
+	t->ign = jctl_ignore_retain(ign);
+	if(namelen > 0)
+		t->len = jctl_graph_glob_join(t->path, path, len, name, namelen);
+	else
+	{
+		memcpy(t->path, path, len);
+		t->path[len] = '\0';
+		t->len = len;
+	}
+	return t;
+}
+
+
+/*
+ * Free walk task 't'.
+ */
+static void jctl_graph_walk_task_free (jctl_graph_walk_task *t)
+{
+	jctl_ignore_release(t->ign);
+	free(t);
+}
+
+
+/*
+ * Pool task walking directory 'arg' of length 'len',
+ * a malloc'ed 'jctl_graph_walk_task'.
+ *
+ * Regular files get registered and counted in chunks,
+ * subdirectories are submitted as walker tasks of their own,
+ * both to the deque of the walking worker so idle workers
+ * can steal them while the walk goes on.
+ * Symbolic links are neither followed nor counted.
+ *
+ * Unless '--no-ignore' is given, the rules of the ignore files
+ * of the directory and those above it are matched against
+ * every name before anything is done with it, so ignored
+ * directories are never opened. Neither are ".git" directories.
+ *
+ * The type and inode of an entry are known without a stat,
+ * files only get one if the cache or the files
+ * of the command line need their identity.
+ * Files are opened relative to the directory while it is open.
+ */
+static void jctl_graph_walk (jctl_pool_worker *pw, void *arg, size_t len)
+{
+	jctl_graph_worker *w = (jctl_graph_worker*) pw->ud;
+	jctl_graph *g = w->g;
+	jctl_graph_walk_task *t = (jctl_graph_walk_task*) arg;
+	char *path = t->path;
+
+	/* no separator after the root directory "/" */
+	jctl_uint sep = (path[len - 1] != '/');
+
+	jctl_dir dir;
+	if(jctl_dir_open(&dir, path))
+	{
+		jctl_graph_walk_task_free(t);
+		return;
+	}
+
+	int dirfd = jctl_dir_fd(&dir);
+	jctl_graph_dir *gd = jctl_graph_dir_new(g, dirfd);
+	jctl_size dev = g->stat ? 0 : jctl_dir_dev(&dir);
+
+	jctl_ignore *ign = NULL;
+	if(g->ignore && jctl_ignore_load(&ign, t->ign, dirfd, path, len))
+		atomic_store(&g->overflow, 1);
+
+	jctl_graph_entry batch[JCTL_GRAPH_CHUNK];
+	jctl_uint n = 0;
+
+	jctl_dir_entry de;
+	while(!atomic_load(&g->overflow) && jctl_dir_read(&dir, &de))
+	{
+		if(de.type == JCTL_DIR_TYPE_OTHER)
+			continue;
+
+		/* patterns only apply to files */
+		if(de.type == JCTL_DIR_TYPE_REG && g->filter != NULL && !jctl_filter_match(g->filter, de.name, de.namelen))
+			continue;
+
+		if(g->ignore)
+		{
+			jctl_uint isdir = (de.type == JCTL_DIR_TYPE_DIR);
+			if(isdir && de.namelen == 4 && memcmp(de.name, ".git", 4) == 0)
+				continue;
+			if(jctl_ignore_match(ign, path, len, de.name, de.namelen, isdir))
+				continue;
+		}
+
+		if(de.type == JCTL_DIR_TYPE_DIR)
+		{
+			jctl_graph_walk_task *sub = jctl_graph_walk_task_new(g, ign, path, len, de.name, de.namelen);
+			if(sub == NULL)
+				break;
+			if(jctl_graph_walk_visit(g, dirfd, (dirfd >= 0) ? de.name : sub->path))
+				jctl_pool_submit(pw->pool, pw, jctl_graph_walk, sub, sub->len);
+			else
+				jctl_graph_walk_task_free(sub);
+			continue;
+		}
+
+		size_t fplen = len + sep + de.namelen;
+		char *fp = jctl_graph_path_new(g, w, fplen + 1);
+		if(fp == NULL)
+		{
+			atomic_store(&g->overflow, 1);
+			break;
+		}
+		memcpy(fp, path, len);
+		fp[len] = '/';
+		memcpy(fp + len + sep, de.name, de.namelen + 1);
+
+		char *name = (dirfd >= 0) ? de.name : fp;
+
+		/*
+		 * Files named on the command line, found by globs
+		 * or through another link are registered already.
+		 */
+		jctl_file_info fi;
+		memset(&fi, 0, sizeof(fi));
+		fi.reg = 1;
+		fi.dev = dev;
+		fi.ino = de.ino;
+		if((g->stat && jctl_file_stat_at(dirfd, name, &fi)) || !jctl_graph_file_new(g, &fi, fp))
+		{
+			jctl_graph_path_free(g, fp);
+			continue;
+		}
+
+		jctl_graph_entry *e = batch + n++;
+		jctl_graph_entry_init(g, e, fp, de.namelen, len + sep - 1, 1, &fi);
+		e->dir = gd;
+
+		if(n == JCTL_GRAPH_CHUNK)
+		{
+			jctl_graph_walk_push(pw, g, batch, n);
+			n = 0;
+		}
+	}
+
+	jctl_graph_walk_push(pw, g, batch, n);
+
+	/* the chunks still to be counted keep it open */
+	if(gd != NULL)
+		jctl_dir_detach(&dir);
+	jctl_dir_close(&dir);
+	if(gd != NULL)
+		jctl_graph_dir_release(g, gd);
+
+	jctl_ignore_release(ign);
+	jctl_graph_walk_task_free(t);
+}
+
+
+static void jctl_graph_glob_dir (jctl_pool_worker *pw, void *arg, size_t seg);
+
+/*
+ * Submit a task matching segment 'seg' of glob 'gl'
+ * against directory 'path' of length 'len' joined with 'name'
+ * of length 'namelen', to the deque of worker 'pw'.
+ */
+static void jctl_graph_glob_submit (jctl_pool_worker *pw, jctl_graph *g, jctl_graph_glob *gl, const char *path, size_t len, const char *name, size_t namelen, jctl_uint seg)
+{
+	jctl_graph_glob_task *t = (jctl_graph_glob_task*)malloc(sizeof(*t) + len + namelen + 2);
+	if(t == NULL)
+	{
+		atomic_store(&g->overflow, 1);
+		return;
+	}
+	t->gl = gl;
+	t->len = jctl_graph_glob_join(t->path, path, len, name, namelen);
+	jctl_pool_submit(pw->pool, pw, jctl_graph_glob_dir, t, seg);
+}
+
+
+/*
+ * Add file 'fp' of length 'fplen' matched by a glob
+ * to the 'n' entries of 'batch', submitted to be counted once full.
+ * Its name of length 'namelen' ends 'fp', relative to 'dirfd'.
+ * 'fi' has its device and inode, and everything else if 'known'.
+ * Takes over 'fp', like the walk in 'jctl_graph_glob_walk'.
+ */
+static void jctl_graph_glob_file (jctl_pool_worker *pw, jctl_graph *g, jctl_graph_entry *batch, jctl_uint *n, jctl_graph_dir *gd, int dirfd, char *fp, size_t fplen, size_t namelen, jctl_file_info *fi, jctl_uint known)
+{
+	char *name = fp + fplen - namelen;
+
+	/*
+	 * Files named on the command line, found by other globs
+	 * or through another link are registered already.
+	 */
+	if((g->filter != NULL && !jctl_filter_match(g->filter, name, namelen))
+		|| (!known && g->stat && jctl_file_stat_at(dirfd, (dirfd >= 0) ? name : fp, fi))
+		|| !jctl_graph_file_new(g, fi, fp))
+	{
+		jctl_graph_path_free(g, fp);
+		return;
+	}
+
+	jctl_graph_entry *e = batch + (*n)++;
+	jctl_graph_entry_init(g, e, fp, namelen, (fplen > namelen) ? fplen - namelen - 1 : 0, 1, fi);
+	e->dir = gd;
+
+	if(*n == JCTL_GRAPH_CHUNK)
+	{
+		jctl_graph_walk_push(pw, g, batch, *n);
+		*n = 0;
+	}
+}
+
+
+/*
+ * Walk directory 'fp' of length 'fplen' matched by a glob with '-r',
+ * its name of length 'namelen' ends 'fp', relative to 'dirfd'.
+ */
+static void jctl_graph_glob_walk (jctl_pool_worker *pw, jctl_graph *g, int dirfd, char *fp, size_t fplen, size_t namelen)
+{
+	if(jctl_graph_walk_visit(g, dirfd, (dirfd >= 0) ? fp + fplen - namelen : fp))
+	{
+		jctl_graph_walk_task *t = jctl_graph_walk_task_new(g, NULL, fp, fplen, "", 0);
+		if(t != NULL)
+			jctl_pool_submit(pw->pool, pw, jctl_graph_walk, t, t->len);
+	}
+	jctl_graph_path_free(g, fp);
+}
+
+
+/*
+ * Go on with glob 'gl' at segment 'seg' in directory 'path' of length 'len'.
+ * Literal segments are appended to the path without reading a directory.
+ * A path made of them up to the end of the glob is taken if it exists,
+ * files are added to the 'n' entries of 'batch'.
+ * Otherwise a task matching the next segment gets submitted.
+ */
+static void jctl_graph_glob_descend (jctl_pool_worker *pw, jctl_graph *g, jctl_graph_glob *gl, const char *path, size_t len, jctl_uint seg, jctl_graph_entry *batch, jctl_uint *n)
+{
+	if(gl->segs[seg].kind != JCTL_GRAPH_GLOB_LITERAL)
+	{
+		jctl_graph_glob_submit(pw, g, gl, path, len, "", 0, seg);
+		return;
+	}
+
+	size_t fplen = len;
+	size_t namelen = 0;
+	for(jctl_uint i = seg; i < gl->n && gl->segs[i].kind == JCTL_GRAPH_GLOB_LITERAL; ++i)
+		fplen += _jctl_strlen(gl->segs[i].s) + 1;
+
+	jctl_graph_worker *w = (jctl_graph_worker*) pw->ud;
+	char *fp = jctl_graph_path_new(g, w, fplen + 1);
+	if(fp == NULL)
+	{
+		atomic_store(&g->overflow, 1);
+		return;
+	}
+
+	fplen = jctl_graph_glob_join(fp, path, len, "", 0);
+	for(; seg < gl->n && gl->segs[seg].kind == JCTL_GRAPH_GLOB_LITERAL; ++seg)
+	{
+		namelen = _jctl_strlen(gl->segs[seg].s);
+		fplen = jctl_graph_glob_join(fp, fp, fplen, gl->segs[seg].s, namelen);
+	}
+
+	if(seg < gl->n)
+	{
+		jctl_graph_glob_submit(pw, g, gl, fp, fplen, "", 0, seg);
+		jctl_graph_path_free(g, fp);
+		return;
+	}
+
+	jctl_file_info fi;
+	if(!jctl_file_stat(fp, &fi))
+		jctl_graph_glob_file(pw, g, batch, n, NULL, -1, fp, fplen, namelen, &fi, 1);
+	else if(g->recursive && !jctl_dir_stat(fp, &fi))
+		jctl_graph_glob_walk(pw, g, -1, fp, fplen, namelen);
+	else
+		jctl_graph_path_free(g, fp);
+}
+
+
+/*
+ * Pool task matching the names of directory 'arg',
+ * a malloc'ed 'jctl_graph_glob_task', against segment 'seg' of its glob.
+ *
+ * Files matched by the last segment get registered and counted in chunks,
+ * directories matched by an earlier one go on with the next segment,
+ * as tasks of their own that idle workers can steal,
+ * so counting starts long before the glob is expanded.
+ *
+ * "**" matches the directory with the segment after it,
+ * and its subdirectories with "**" again,
+ * without following symbolic links.
+ * Like in the shell, names starting with a dot are only
+ * matched by segments starting with a dot, and
+ * symbolic links are followed otherwise.
+ */
+static void jctl_graph_glob_dir (jctl_pool_worker *pw, void *arg, size_t seg)
+{
+	jctl_graph_worker *w = (jctl_graph_worker*) pw->ud;
+	jctl_graph *g = w->g;
+	jctl_graph_glob_task *t = (jctl_graph_glob_task*) arg;
+	jctl_graph_glob *gl = t->gl;
+
+	jctl_uint any = (gl->segs[seg].kind == JCTL_GRAPH_GLOB_ANY);
+	jctl_uint mseg = seg + any;
+	jctl_graph_glob_seg *m = gl->segs + mseg;
+	jctl_uint last = (mseg + 1 == gl->n);
+
+	/* files matched by their path are opened by it */
+	jctl_graph_entry paths[JCTL_GRAPH_CHUNK];
+	jctl_uint npaths = 0;
+	if(m->kind == JCTL_GRAPH_GLOB_LITERAL)
+		jctl_graph_glob_descend(pw, g, gl, t->path, t->len, mseg, paths, &npaths);
+
+	jctl_dir dir;
+	if(jctl_dir_open(&dir, (t->len > 0) ? t->path : "."))
+	{
+		jctl_graph_walk_push(pw, g, paths, npaths);
+		free(t);
+		return;
+	}
+
+	int dirfd = jctl_dir_fd(&dir);
+	jctl_graph_dir *gd = (t->len > 0) ? jctl_graph_dir_new(g, dirfd) : NULL;
+	jctl_size dev = g->stat ? 0 : jctl_dir_dev(&dir);
+
+	jctl_graph_entry files[JCTL_GRAPH_CHUNK];
+	jctl_uint nfiles = 0;
+
+	jctl_dir_entry de;
+	while(!atomic_load(&g->overflow) && jctl_dir_read(&dir, &de))
+	{
+		jctl_uint hidden = (de.name[0] == '.');
+
+		if(any && !hidden && de.type == JCTL_DIR_TYPE_DIR)
+			jctl_graph_glob_submit(pw, g, gl, t->path, t->len, de.name, de.namelen, seg);
+
+		if(m->kind != JCTL_GRAPH_GLOB_WILD || (hidden && !m->hidden) || !wc_dfa_match(&m->dfa, de.name, de.namelen))
+			continue;
+
+		char *fp = jctl_graph_path_new(g, w, t->len + de.namelen + 2);
+		if(fp == NULL)
+		{
+			atomic_store(&g->overflow, 1);
+			break;
+		}
+		size_t fplen = jctl_graph_glob_join(fp, t->path, t->len, de.name, de.namelen);
+		char *name = (dirfd >= 0) ? de.name : fp;
+
+		jctl_dir_type type = de.type;
+		jctl_file_info fi;
+		memset(&fi, 0, sizeof(fi));
+		fi.reg = 1;
+		fi.dev = dev;
+		fi.ino = de.ino;
+		jctl_uint known = 0;
+		if(type == JCTL_DIR_TYPE_OTHER)
+		{
+			if(!jctl_file_stat_at(dirfd, name, &fi) && fi.reg)
+			{
+				type = JCTL_DIR_TYPE_REG;
+				known = 1;
+			}
+			else if(!jctl_dir_stat_at(dirfd, name, &fi))
+			{
+				type = JCTL_DIR_TYPE_DIR;
+			}
+			else
+			{
+				jctl_graph_path_free(g, fp);
+				continue;
+			}
+		}
+
+		if(!last)
+		{
+			if(type == JCTL_DIR_TYPE_DIR)
+				jctl_graph_glob_descend(pw, g, gl, fp, fplen, mseg + 1, paths, &npaths);
+			jctl_graph_path_free(g, fp);
+			continue;
+		}
+
+		if(type == JCTL_DIR_TYPE_DIR)
+		{
+			if(g->recursive)
+				jctl_graph_glob_walk(pw, g, dirfd, fp, fplen, de.namelen);
+			else
+				jctl_graph_path_free(g, fp);
+			continue;
+		}
+
+		jctl_graph_glob_file(pw, g, files, &nfiles, gd, dirfd, fp, fplen, de.namelen, &fi, known);
+	}
+
+	jctl_graph_walk_push(pw, g, files, nfiles);
+	jctl_graph_walk_push(pw, g, paths, npaths);
+
+	/* the chunks still to be counted keep it open */
+	if(gd != NULL)
+		jctl_dir_detach(&dir);
+	jctl_dir_close(&dir);
+	if(gd != NULL)
+		jctl_graph_dir_release(g, gd);
+
+	free(t);
+}
+
+
+/*
+ * Pool task starting the expansion of glob 'arg'.
+ */
+static void jctl_graph_glob_start (jctl_pool_worker *pw, void *arg, size_t i)
+{
+	jctl_graph_worker *w = (jctl_graph_worker*) pw->ud;
+	jctl_graph_glob *gl = (jctl_graph_glob*) arg;
+
+	jctl_graph_entry batch[JCTL_GRAPH_CHUNK];
+	jctl_uint n = 0;
+	if(gl->n > 0)
+		jctl_graph_glob_descend(pw, w->g, gl, gl->absolute ? "/" : "", gl->absolute, 0, batch, &n);
+	jctl_graph_walk_push(pw, w->g, batch, n);
+}
+
+
+/*
+ * Register name 'fn' of length 'len' read from a file list by worker 'pw'
+ * of graph 'g', as 'jctl_graph_name_new' does for the command line:
+ * with '-r' directories get walked, wildcards naming no file
+ * get expanded as globs, and files get added to the 'n' entries
+ * of 'batch', submitted to be counted once full.
+ * Files get a path of their own, the list buffer gets reused.
+ */
+static void jctl_graph_list_name (jctl_pool_worker *pw, jctl_graph *g, char *fn, size_t len, jctl_graph_entry *batch, jctl_uint *n)
+{
+	jctl_graph_worker *w = (jctl_graph_worker*) pw->ud;
+	jctl_file_info fi;
+	memset(&fi, 0, sizeof(fi));
+
+	if(g->recursive && jctl_graph_walk_visit(g, -1, fn))
+	{
+		while(len > 1 && fn[len - 1] == '/')
+			--len;
+		jctl_graph_walk_task *t = jctl_graph_walk_task_new(g, NULL, fn, len, "", 0);
+		if(t != NULL)
+			jctl_pool_submit(pw->pool, pw, jctl_graph_walk, t, t->len);
+		return;
+	}
+
+	if(wc_correct(fn) && jctl_file_stat(fn, &fi) && jctl_dir_stat(fn, &fi))
+	{
+		pthread_mutex_lock(&g->lock);
+		jctl_graph_glob *gl = jctl_graph_glob_new(g, fn, (jctl_uint) len);
+		pthread_mutex_unlock(&g->lock);
+		if(gl == NULL)
+			atomic_store(&g->overflow, 1);
+		else
+			jctl_pool_submit(pw->pool, pw, jctl_graph_glob_start, gl, 0);
+		return;
+	}
+
+	char *lslsh = strrchr(fn, '/');
+	char *name = (lslsh != NULL) ? lslsh + 1 : fn;
+	size_t namelen = len - (size_t)(name - fn);
+	if((g->filter != NULL && !jctl_filter_match(g->filter, name, namelen))
+		|| jctl_file_stat(fn, &fi)
+		|| !jctl_graph_file_new(g, &fi, fn))
+	{
+		return;
+	}
+
+	char *fp = jctl_graph_path_new(g, w, len + 1);
+	if(fp == NULL)
+	{
+		atomic_store(&g->overflow, 1);
+		return;
+	}
+	memcpy(fp, fn, len + 1);
+
+	jctl_graph_entry *e = batch + (*n)++;
+	jctl_graph_entry_init(g, e, fp, (jctl_uint) namelen, (lslsh != NULL) ? (jctl_uint)(lslsh - fn) : 0, 1, &fi);
+
+	if(*n == JCTL_GRAPH_CHUNK)
+	{
+		jctl_graph_walk_push(pw, g, batch, *n);
+		*n = 0;
+	}
+}
+
+
+/*
+ * Pool task reading the next part of file list 'arg'
+ * and registering its names, submitting itself again
+ * for the part after it until the list ends.
+ * Idle workers steal the chunks of a part
+ * while the next one is being read.
+ */
+static void jctl_graph_list_read (jctl_pool_worker *pw, void *arg, size_t i)
+{
+	jctl_graph_worker *w = (jctl_graph_worker*) pw->ud;
+	jctl_list *l = (jctl_list*) arg;
+
+	if(jctl_list_read(l))
+		return;
+
+	jctl_graph_entry batch[JCTL_GRAPH_CHUNK];
+	jctl_uint n = 0;
+	char *fn;
+	size_t len;
+	while((fn = jctl_list_next(l, &len)) != NULL)
+		jctl_graph_list_name(pw, w->g, fn, len, batch, &n);
+	jctl_graph_walk_push(pw, w->g, batch, n);
+
+	jctl_pool_submit(pw->pool, pw, jctl_graph_list_read, l, 0);
+}
+
+
+/*
+ * Pool task counting the byte range 'i' of split entry 'arg'.
+ */
+static void jctl_graph_count_range (jctl_pool_worker *pw, void *arg, size_t i)
+{
+	jctl_graph_split *sp = (jctl_graph_split*) arg;
+	jctl_graph_worker *w = (jctl_graph_worker*) pw->ud;
+	jctl_graph_entry *e = sp->e;
+
+	/*
+	 * The last range goes on until the end of file,
+	 * in case the file has grown since it was registered.
+	 */
+	jctl_size part = e->fi.size / sp->n;
+	jctl_size start = part * i;
+	jctl_size end = (i + 1 == sp->n) ? JCTL_FILE_EOF : part * (i + 1);
+
+	sp->err[i] = jctl_file_linecount_range(&w->buf, e->fn, start, end, sp->tails + i);
+}
+
+
+/*
+ * Check if entry 'e' is worth splitting into byte ranges.
+ * Cached entries need no counting at all,
+ * and appended ones only need their new tail counted.
+ */
+static inline int jctl_graph_split_wanted (jctl_graph_entry *e)
+{
+	return !e->cached && e->tail.size == 0 && e->fi.size >= JCTL_GRAPH_SPLIT_MIN;
+}
+
+
+/*
+ * Split the big entries of graph 'g' into byte ranges
+ * for 'jobs' threads to count at once.
+ *
+ * Return the amount of ranges,
+ * or 0 if there is nothing to split (or out of memory).
+ */
+static jctl_uint jctl_graph_split_entries (jctl_graph *g, jctl_uint jobs)
+{
+	g->splittop = 0;
+	g->splits = NULL;
+
+	if(jobs < 2)
+		return 0;
+
+	jctl_uint count = 0;
+	for(jctl_uint i = 0; i < g->entrytop; ++i)
+		count += jctl_graph_split_wanted(jctl_graph_entry_at(g, i));
+
+	if(count == 0)
+		return 0;
+
+	g->splits = (jctl_graph_split*)malloc(sizeof(*g->splits) * count);
+	if(g->splits == NULL)
+		return 0;
+
+	jctl_uint ranges = 0;
+	for(jctl_uint i = 0; i < g->entrytop; ++i)
+	{
+		jctl_graph_entry *e = jctl_graph_entry_at(g, i);
+		if(!jctl_graph_split_wanted(e))
+			continue;
+
+		jctl_size n = e->fi.size / JCTL_GRAPH_SPLIT_PART;
+		if(n > (jctl_size) jobs * JCTL_GRAPH_SPLIT_FACTOR)
+			n = (jctl_size) jobs * JCTL_GRAPH_SPLIT_FACTOR;
+
+		/*
+		 * Leave the file whole if the
+		 * range arrays can't be allocated.
+		 */
+		jctl_file_tail *tails = (jctl_file_tail*)calloc(n, sizeof(*tails));
+		jctl_uint *err = (jctl_uint*)calloc(n, sizeof(*err));
+		if(tails == NULL || err == NULL)
+		{
+			free(tails);
+			free(err);
+			continue;
+		}
+
+		jctl_graph_split *sp = g->splits + g->splittop++;
+		sp->e = e;
+		sp->n = (jctl_uint) n;
+		sp->tails = tails;
+		sp->err = err;
+		e->split = 1;
+		ranges += sp->n;
+	}
+
+	return ranges;
+}
+
+
+/*
+ * Sum up the ranges of the split entries of graph 'g'.
+ * With '--stream' they get printed by worker 'w',
+ * with '--top' they go to its heap.
+ */
+static void jctl_graph_split_merge (jctl_graph *g, jctl_graph_worker *w)
+{
+	for(jctl_uint i = 0; i < g->splittop; ++i)
+	{
+		jctl_graph_split *sp = g->splits + i;
+		jctl_graph_entry *e = sp->e;
+
+		/* the initial line, as in 'jctl_file_linecount' */
+		e->lc = 1;
+		for(jctl_uint k = 0; k < sp->n; ++k)
+		{
+			e->lc += sp->tails[k].lc;
+			e->skip |= sp->err[k];
+		}
+
+		/*
+		 * The last range ends where the whole file does,
+		 * but a file ending in a run of line breaks leaves
+		 * the ranges within it empty (their size is 0),
+		 * and moves the start of the last one to its end.
+		 * A line break still waiting for its pair is the one
+		 * of the last range that counted any bytes.
+		 */
+		jctl_uint last = sp->n - 1;
+		while(last > 0)
+		{
+			jctl_uint prev = last - 1;
+			while(prev > 0 && sp->tails[prev].size == 0)
+				--prev;
+			if(sp->tails[last].size != 0 && sp->tails[last].size != sp->tails[prev].size)
+				break;
+			last = prev;
+		}
+		e->tail = sp->tails[sp->n - 1];
+		e->tail.lc = e->lc - 1;
+		e->tail.pend = sp->tails[last].pend;
+
+		free(sp->tails);
+		free(sp->err);
+
+		if(e->skip)
+			continue;
+
+		g->glc += e->lc;
+		if(e->fnlen > g->hfnlen)
+			g->hfnlen = e->fnlen;
+		if(e->dirlen > g->hdirlen)
+			g->hdirlen = e->dirlen;
+
+		if(g->bydir || g->byext)
+			jctl_graph_rollup_add(w, e);
+
+		if(g->stream)
+			jctl_graph_stream_entry(w, e);
+		else if(g->top > 0)
+			jctl_graph_heap_push(g, w->heap, &w->heaptop, e);
+	}
+
+	if(g->stream)
+		jctl_out_flush(&w->out);
+
+	free(g->splits);
+}
+
+
+/*
+ * Count all registered graph entries of graph 'g'
+ * using 'cfg->jobs' threads and merge their totals.
+ *
+ * Return 0 if the entries got counted,
+ * otherwise (out of memory) return 1.
+ */
+static jctl_uint jctl_graph_count (jctl_graph *g, jctl_graph_config *cfg)
+{
+	jctl_uint jobs = cfg->jobs;
+	jctl_uint ranges = jctl_graph_split_entries(g, jobs);
+
+	/*
+	 * No point in starting more threads than tasks,
+	 * unless walking directories turns up more.
+	 */
+	jctl_uint chunks = (g->entrytop + JCTL_GRAPH_CHUNK - 1) / JCTL_GRAPH_CHUNK;
+	if(jobs > chunks + ranges && g->roottop == 0 && g->globtop == 0 && g->list == NULL)
+		jobs = chunks + ranges;
+	if(jobs < 1)
+		jobs = 1;
+
+	/* the worker reading a file list waits for it, another one counts meanwhile */
+	if(g->list != NULL && jobs < 2)
+		jobs = 2;
+
+	g->pool = jctl_pool_new(jobs);
+	if(g->pool == NULL)
+		return 1;
+
+	g->workers = (jctl_graph_worker*)calloc(jobs, sizeof(*g->workers));
+	if(g->workers == NULL)
+		return 1;
+
+	for(jctl_uint i = 0; i < jobs; ++i)
+	{
+		jctl_graph_worker *w = g->workers + i;
+		w->g = g;
+		jctl_arena_init(&w->names);
+		jctl_rollup_init(&w->rdirs);
+		jctl_rollup_init(&w->rexts);
+		if(jctl_file_buffer_init(&w->buf, cfg->bufsize))
+			return 1;
+		if(g->stream)
+		{
+			if(jctl_out_init(&w->out, fileno(stdout), JCTL_GRAPH_STREAM_BUFSIZE))
+				return 1;
+			w->out.lock = &g->outlock;
+		}
+		if(g->top > 0)
+		{
+			w->heap = (jctl_graph_entry*)malloc(sizeof(*w->heap) * g->top);
+			if(w->heap == NULL)
+				return 1;
+		}
+		/* falls back to reading if the kernel has no io_uring */
+		if(cfg->uring)
+			w->uring = jctl_uring_new();
+		g->pool->workers[i].ud = w;
+	}
+
+	for(jctl_uint i = 0; i < g->splittop; ++i)
+		for(jctl_uint k = 0; k < g->splits[i].n; ++k)
+			jctl_pool_submit(g->pool, NULL, jctl_graph_count_range, g->splits + i, k);
+
+	/* blocks are multiples of a chunk, no chunk spans two */
+	for(jctl_uint i = 0; i < g->entrytop; i += JCTL_GRAPH_CHUNK)
+	{
+		size_t n = g->entrytop - i;
+		if(n > JCTL_GRAPH_CHUNK)
+			n = JCTL_GRAPH_CHUNK;
+		jctl_pool_submit(g->pool, NULL, jctl_graph_count_chunk, jctl_graph_entry_at(g, i), n);
+	}
+
+	/*
+	 * The walkers and globs register the entries they find
+	 * past the ones of the command line.
+	 */
+	for(jctl_uint i = 0; i < g->globtop; ++i)
+		jctl_pool_submit(g->pool, NULL, jctl_graph_glob_start, g->globs[i], 0);
+
+	for(jctl_uint i = 0; i < g->roottop; ++i)
+	{
+		jctl_graph_walk_task *t = jctl_graph_walk_task_new(g, NULL, g->roots[i], _jctl_strlen(g->roots[i]), "", 0);
+		if(t != NULL)
+			jctl_pool_submit(g->pool, NULL, jctl_graph_walk, t, t->len);
+	}
+
+	if(g->list != NULL)
+		jctl_pool_submit(g->pool, NULL, jctl_graph_list_read, g->list, 0);
+
+	jctl_uint err = jctl_pool_run(g->pool);
+	err |= atomic_load(&g->overflow);
+
+	jctl_graph_split_merge(g, g->workers);
+
+	/*
+	 * Merge the worker totals,
+	 * and the worker heaps into the one of the graph.
+	 */
+	jctl_graph_entry *heap = NULL;
+	jctl_uint heaptop = 0;
+	if(g->top > 0 && (heap = (jctl_graph_entry*)malloc(sizeof(*heap) * g->top)) == NULL)
+		err = 1;
+
+	for(jctl_uint i = 0; i < jobs; ++i)
+	{
+		jctl_graph_worker *w = g->workers + i;
+		g->glc += w->glc;
+		if(w->hfnlen > g->hfnlen)
+			g->hfnlen = w->hfnlen;
+		if(w->hdirlen > g->hdirlen)
+			g->hdirlen = w->hdirlen;
+		jctl_file_buffer_free(&w->buf);
+		jctl_uring_free(w->uring);
+		jctl_arena_merge(&g->names, &w->names);
+		jctl_out_free(&w->out);
+		if(jctl_rollup_merge(&g->rdirs, &w->rdirs) | jctl_rollup_merge(&g->rexts, &w->rexts))
+			err = 1;
+		for(jctl_uint k = 0; k < w->heaptop; ++k)
+		{
+			if(heap != NULL)
+				jctl_graph_heap_push(g, heap, &heaptop, w->heap + k);
+			else
+				jctl_graph_entry_drop(g, w->heap + k);
+		}
+		free(w->heap);
+	}
+
+	free(g->workers);
+	jctl_pool_free(g->pool);
+
+	/*
+	 * Gather the entries into one array for sorting,
+	 * drop the ones that couldn't be read,
+	 * and remember the counted ones in the cache.
+	 * Dropped entries are printed already, or in the heap.
+	 */
+	if(!g->drop)
+	{
+		g->entries = (jctl_graph_entry*)malloc(sizeof(*g->entries) * (g->entrytop + 1));
+		if(g->entries == NULL)
+			err = 1;
+	}
+
+	jctl_uint top = 0;
+	for(jctl_uint b = 0, i = 0; b < g->nblocks && (g->drop || g->entries != NULL); ++b)
+	{
+		for(jctl_uint end = jctl_graph_entry_block_end(i); i < end && i < g->entrytop; ++i)
+		{
+			jctl_graph_entry *e = g->blocks[b] + (i - JCTL_GRAPH_ENTRY_BLOCK * ((1u << b) - 1));
+			if(e->skip)
+				continue;
+			if(g->cache != NULL && !e->cached)
+				jctl_cache_put(g->cache, &e->fi, e->lc, &e->tail);
+			if(!g->drop)
+				g->entries[top++] = *e;
+		}
+		free(g->blocks[b]);
+	}
+	g->entrytop = top;
+	g->nblocks = 0;
+
+	/*
+	 * With '--top' the heap holds the entries to print,
+	 * padded for their names only.
+	 */
+	if(g->top > 0)
+	{
+		g->entries = heap;
+		g->entrytop = heaptop;
+		g->hfnlen = 0;
+		g->hdirlen = 0;
+		for(jctl_uint i = 0; i < heaptop; ++i)
+		{
+			if(heap[i].fnlen > g->hfnlen)
+				g->hfnlen = heap[i].fnlen;
+			if(heap[i].dirlen > g->hdirlen)
+				g->hdirlen = heap[i].dirlen;
+		}
+	}
+
+	/* directories sum up the ones below them */
+	if(g->bydir && jctl_rollup_parents(&g->rdirs))
+		err = 1;
+
+	/* a cache that can't be saved only costs the next run time */
+	if(g->cache != NULL)
+	{
+		jctl_cache_save(g->cache);
+		jctl_cache_free(g->cache);
+		g->cache = NULL;
+	}
+
+	return err;
+}
+
+
+/*
+ * Register name 'fn' of length 'len' given to graph 'g'
+ * on the command line, those of file lists come while counting.
+ * With '-r' directories get walked, without a trailing slash
+ * (but "/" stays), everything else is a graph entry.
+ */
+static void jctl_graph_name_new (ofp_state *S, jctl_graph *g, char *fn, size_t len)
+{
+	if(g->recursive && jctl_graph_walk_visit(g, -1, fn))
+	{
+		while(len > 1 && fn[len - 1] == '/')
+			fn[--len] = '\0';
+
+		if(g->roottop == g->rootcap)
+		{
+			char **roots = (char**)realloc(g->roots, sizeof(*roots) * g->rootcap * 2);
+			if(roots == NULL)
+				jctl_graph_throw(g);
+			g->roots = roots;
+			g->rootcap *= 2;
+		}
+		g->roots[g->roottop++] = fn;
+		return;
+	}
+
+	jctl_graph_entry_new(S, g, fn, (jctl_uint) len, 0, 0);
+}
+
+
+/*
+ * Run a graph for OFP state 'S' and configuration 'cfg';
+ * Register graph entries and print them sorted by order 'cfg->so'.
+ *
+ * Return 0 if the routine ran successfuly, otherwise its error bits:
+ * JCTL_GRAPH_ERR_SNAPSHOT if the snapshot couldn't be saved,
+ * JCTL_GRAPH_ERR_MEMORY if out of memory.
+ */
+jctl_uint jctl_graph_run (ofp_state *S, jctl_graph_config *cfg)
+{
+	jctl_graph *g = (jctl_graph*)malloc(sizeof(*g));
+	if(g == NULL)
+		return 1;
+
+	g->entries = NULL;
+	g->entrytop = 0;
+	g->entrycap = 0;
+	g->nblocks = 0;
+	jctl_arena_init(&g->names);
+
+	if(setjmp(g->errbuf))
+		return 1;
+
+	/* the listing is written around stdio */
+	fflush(stdout);
+
+	/* initialize members */
+	g->glc = 0;
+	g->hfnlen = 0;
+	g->hdirlen = 0;
+	g->roottop = 0;
+	g->globtop = 0;
+	g->filter = cfg->filter;
+	g->recursive = cfg->recursive;
+	g->ignore = cfg->ignore;
+	g->remember = 1;
+	g->stream = cfg->stream;
+	g->so = cfg->so;
+	g->top = cfg->top;
+	g->keep = cfg->keep;
+	g->bydir = cfg->bydir;
+	g->dirdepth = cfg->dirdepth;
+	g->byext = cfg->byext;
+	g->format = cfg->format;
+	g->list = cfg->list;
+	g->drop = (g->stream || g->top > 0 || g->bydir || g->byext);
+	jctl_rollup_init(&g->rdirs);
+	jctl_rollup_init(&g->rexts);
+	atomic_init(&g->streamfn, JCTL_GRAPH_STREAM_NAME);
+	atomic_init(&g->streamlc, JCTL_GRAPH_STREAM_COUNT);
+	atomic_init(&g->overflow, 0);
+	atomic_init(&g->dirsopen, 0);
+	pthread_mutex_init(&g->lock, NULL);
+	pthread_mutex_init(&g->outlock, NULL);
+	jctl_set_init(&g->dirs);
+	jctl_set_shared_init(&g->files);
+
+	g->rootcap = S->nalt + 1;
+	g->globcap = S->nalt + 1;
+	g->roots = (char**)malloc(sizeof(*g->roots) * g->rootcap);
+	g->globs = (jctl_graph_glob**)malloc(sizeof(*g->globs) * g->globcap);
+	if(g->roots == NULL || g->globs == NULL)
+		return 1;
+
+	/*
+	 * Open the cache before the entries get registered,
+	 * files modified after this are never cached.
+	 */
+	g->cache = cfg->cache ? jctl_cache_open() : NULL;
+
+	/*
+	 * Iterate through NAL
+	 * and register graph entries.
+	 */
+	for(ofp_uint i = 0; i < S->nalt; ++i)
+	{
+		char *fn = S->nal[i];
+		if(fn != NULL)
+			jctl_graph_name_new(S, g, fn, _jctl_strlen(fn));
+	}
+
+	/*
+	 * The files of the command line and of file lists are known by the inode stat tells,
+	 * which the one of a directory entry may differ from
+	 * (overlay filesystems), so walkers and globs stat theirs too.
+	 */
+	g->stat = (g->cache != NULL || g->entrytop > 0 || g->list != NULL);
+
+	/* records of '--format' and snapshots hold the file sizes */
+	g->stat |= (g->format != JCTL_EMIT_TEXT || cfg->snapshot != NULL);
+
+	/*
+	 * Dropped files aren't remembered by walkers and globs,
+	 * unless several of them (or a file list) may find the same ones.
+	 * A single walk never reaches a file twice, but through hard links.
+	 */
+	g->remember = (!g->drop || g->globtop > 0 || g->roottop > 1 || g->list != NULL);
+
+	/* machine formats start with their header, before any streamed record */
+	jctl_out o;
+	if(jctl_out_init(&o, fileno(stdout), JCTL_OUT_BUFSIZE))
+		return 1;
+	jctl_emit_begin(&o, g->format);
+	jctl_out_flush(&o);
+
+	jctl_uint err = jctl_graph_count(g, cfg);
+
+	jctl_set_free(&g->dirs);
+	jctl_set_shared_free(&g->files);
+	pthread_mutex_destroy(&g->lock);
+	pthread_mutex_destroy(&g->outlock);
+	free(g->roots);
+	for(jctl_uint i = 0; i < g->globtop; ++i)
+		jctl_graph_glob_free(g->globs[i]);
+	free(g->globs);
+
+	if(err)
+	{
+		jctl_out_free(&o);
+		return 1;
+	}
+
+	/*
+	 * With '--by-dir' and '--by-ext' the roll-ups take the place of
+	 * the files, unless these are streamed or the first ones kept.
+	 */
+	jctl_uint listed = 1;
+	jctl_uint rollerr = 0;
+	if(g->stream)
+	{
+		if(g->format == JCTL_EMIT_TEXT)
+			jctl_graph_stream_total(g, &o);
+	}
+	else if(g->entries != NULL)
+	{
+		/* the listing is printed either way */
+		if(cfg->snapshot != NULL && jctl_graph_snapshot(S, g, cfg->snapshot))
+			err = JCTL_GRAPH_ERR_SNAPSHOT;
+
+		jctl_graph_sort(S, g, cfg->so);
+		if(g->format == JCTL_EMIT_TEXT)
+			jctl_graph_print(S, g, &o);
+		else
+			jctl_graph_emit(g, &o);
+	}
+	else
+	{
+		listed = 0;
+	}
+
+	if(g->bydir)
+	{
+		if(listed)
+			jctl_out_write(&o, "\n", 1);
+		rollerr |= jctl_graph_print_rollup(S, g, &g->rdirs, cfg->so, &o);
+		listed = 1;
+	}
+	if(g->byext)
+	{
+		if(listed)
+			jctl_out_write(&o, "\n", 1);
+		rollerr |= jctl_graph_print_rollup(S, g, &g->rexts, cfg->so, &o);
+	}
+	if(rollerr)
+		err |= JCTL_GRAPH_ERR_MEMORY;
+
+	jctl_out_flush(&o);
+	jctl_out_free(&o);
+
+	for(jctl_uint i = 0; g->drop && i < g->entrytop; ++i)
+		jctl_graph_entry_drop(g, g->entries + i);
+
+	free(g->entries);
+	jctl_arena_free(&g->names);
+	jctl_rollup_free(&g->rdirs);
+	jctl_rollup_free(&g->rexts);
+
+	return err;
+}
@@ -1,72 +1,355 @@
-#ifndef JCTL_GRAPH_H
-#define JCTL_GRAPH_H
-
-#include "jctl.h"
-#include "ofp/ofp.h"
-#include <setjmp.h>
-
-
-/*
- * Amount of graph "bars" to show the
- * percentage of line count compared to
- * line count of all inputted files
- */
-#define JCTL_GRAPH_BARS			(25)
-
-/*
- * Amount of the maximum graph entries.
- */
-#define JCTL_GRAPH_MAX_ENTRIES	(1024)
-
-
-/*
-*
-* Graph Sort Order
-*
-*/
-typedef enum jctl_graph_sortorder_e
-{
-	JCTL_GRAPH_SORT_NAME,
-	JCTL_GRAPH_SORT_LINE_INC,
-	JCTL_GRAPH_SORT_LINE_DEC
-} jctl_graph_sortorder;
-
-
-/*
-*
-* Graph Entry
-*
-*/
-typedef struct jctl_graph_entry_s
-{
-	char *fn;			/* filename */
-	jctl_uint wc;		/* uses wildcard */
-	jctl_uint lc;		/* line count */
-	jctl_uint fnlen;	/* filename length */
-	jctl_uint dirlen;	/* directory length */
-} jctl_graph_entry;
-
-
-/*
-*
-* Graph Context
-*
-* "Highest" values exist for printing the
-* padding in the 'jctl_graph_print' function.
-*
-*/
-typedef struct jctl_graph_s
-{
-	jmp_buf errbuf;				/* error buffer */
-	jctl_uint glc;				/* global line count */
-	jctl_uint hfnlen;			/* highest filename length */
-	jctl_uint hdirlen;			/* highest directory length */
-	jctl_uint entrytop;			/* top entry index */
-	jctl_graph_entry *entries;	/* entry stack */
-} jctl_graph;
-
-
-jctl_uint jctl_graph_run (ofp_state *S, jctl_graph_sortorder so);
-
-
-#endif /* JCTL_GRAPH_H */
+#ifndef JCTL_GRAPH_H
+#define JCTL_GRAPH_H
+
+#include "jctl.h"
+#include "file.h"
+#include "pool.h"
+#include "uring.h"
+#include "cache.h"
+#include "set.h"
+#include "dir.h"
+#include "arena.h"
+#include "filter.h"
+#include "wildcard.h"
+#include "out.h"
+#include "rollup.h"
+#include "emit.h"
+#include "snap.h"
+#include "list.h"
+#include "ignore.h"
+#include "ofp/ofp.h"
+#include <setjmp.h>
+
+
+/*
+ * Amount of graph "bars" to show the
+ * percentage of line count compared to
+ * line count of all inputted files
+ */
+#define JCTL_GRAPH_BARS			(25)
+
+/*
+ * Graph entries are stored in blocks that never move,
+ * the first one of JCTL_GRAPH_ENTRY_BLOCK entries,
+ * every further one twice as big as the one before.
+ * JCTL_GRAPH_ENTRY_BLOCKS blocks hold as many entries as a jctl_uint counts.
+ */
+#define JCTL_GRAPH_ENTRY_BLOCK	(1024)
+#define JCTL_GRAPH_ENTRY_BLOCKS	(22)
+
+/*
+ * Amount of graph entries counted by one pool task.
+ * Idle threads steal whole chunks from busy ones.
+ */
+#define JCTL_GRAPH_CHUNK		(16)
+
+/*
+ * Files of at least JCTL_GRAPH_SPLIT_MIN bytes get split
+ * into byte ranges of at least JCTL_GRAPH_SPLIT_PART bytes,
+ * counted by several threads at once.
+ * A file is split into at most JCTL_GRAPH_SPLIT_FACTOR ranges per thread.
+ */
+#define JCTL_GRAPH_SPLIT_MIN	(64 * 1024 * 1024)
+#define JCTL_GRAPH_SPLIT_PART	(16 * 1024 * 1024)
+#define JCTL_GRAPH_SPLIT_FACTOR	(4)
+
+/*
+ * Amount of walked directories kept open at most
+ * for counting their files relative to them.
+ */
+#define JCTL_GRAPH_DIRS_OPEN	(256)
+
+/*
+ * With '--stream' every counting thread collects the lines
+ * of its files in a writer of JCTL_GRAPH_STREAM_BUFSIZE bytes,
+ * written out once a chunk is counted.
+ * The name and line count columns start JCTL_GRAPH_STREAM_NAME
+ * and JCTL_GRAPH_STREAM_COUNT characters wide
+ * and grow with the widest ones printed so far.
+ */
+#define JCTL_GRAPH_STREAM_BUFSIZE	(64 * 1024)
+#define JCTL_GRAPH_STREAM_NAME		(32)
+#define JCTL_GRAPH_STREAM_COUNT		(6)
+
+/*
+ * Most files '--top' and '--bottom' keep,
+ * every counting thread holds a heap of that many.
+ */
+#define JCTL_GRAPH_TOP_MAX			(1024 * 1024)
+
+/*
+ * Error bits returned by 'jctl_graph_run': out of memory,
+ * and the files got counted and printed, but the snapshot
+ * of '--save-snapshot' couldn't be written.
+ */
+#define JCTL_GRAPH_ERR_MEMORY		(1)
+#define JCTL_GRAPH_ERR_SNAPSHOT		(2)
+
+/*
+ * Most directory levels '--by-dir=depth' takes.
+ */
+#define JCTL_GRAPH_DIR_DEPTH_MAX	(4096)
+
+
+/*
+*
+* Graph Sort Order
+*
+*/
+typedef enum jctl_graph_sortorder_e
+{
+	JCTL_GRAPH_SORT_NAME,
+	JCTL_GRAPH_SORT_LINE_INC,
+	JCTL_GRAPH_SORT_LINE_DEC
+} jctl_graph_sortorder;
+
+
+/*
+*
+* Graph Configuration
+*
+*/
+typedef struct jctl_graph_config_s
+{
+	jctl_graph_sortorder so;	/* sort order */
+	size_t bufsize;				/* read buffer size */
+	jctl_uint jobs;				/* counting threads */
+	jctl_uint uring;			/* read small files with io_uring */
+	jctl_uint cache;			/* reuse line counts of unchanged files */
+	jctl_uint recursive;		/* walk directories */
+	jctl_uint ignore;			/* walkers honour ignore files */
+	jctl_filter *filter;		/* include and exclude patterns, NULL if none */
+	jctl_uint stream;			/* print files as they are counted */
+	jctl_uint top;				/* only keep the first files in order 'keep', 0 for all */
+	jctl_graph_sortorder keep;	/* order the files get kept in, with 'top' */
+	jctl_uint bydir;			/* sum up lines by directory */
+	jctl_uint dirdepth;			/* directory levels summed up, 0 for all */
+	jctl_uint byext;			/* sum up lines by extension */
+	jctl_emit_format format;	/* output format */
+	const char *snapshot;		/* snapshot file to save, NULL if none */
+	jctl_list *list;			/* opened list of '--files-from', NULL if none */
+} jctl_graph_config;
+
+
+/*
+*
+* Graph Directory
+*
+* Walked directory kept open until all its files are counted.
+*
+*/
+typedef struct jctl_graph_dir_s
+{
+	int fd;				/* directory file descriptor */
+	atomic_uint refs;	/* walker and chunks still using it */
+} jctl_graph_dir;
+
+
+/*
+*
+* Graph Glob Segment
+*
+* Part of a glob between two slashes.
+*
+*/
+typedef enum jctl_graph_glob_kind_e
+{
+	JCTL_GRAPH_GLOB_LITERAL,	/* plain name */
+	JCTL_GRAPH_GLOB_WILD,		/* wildcard matched against the names of a directory */
+	JCTL_GRAPH_GLOB_ANY			/* "**", any amount of directories */
+} jctl_graph_glob_kind;
+
+typedef struct jctl_graph_glob_seg_s
+{
+	char *s;					/* segment */
+	jctl_graph_glob_kind kind;	/* segment kind */
+	jctl_uint hidden;			/* matches names starting with a dot */
+	wc_dfa dfa;					/* compiled wildcard, if JCTL_GRAPH_GLOB_WILD */
+} jctl_graph_glob_seg;
+
+
+/*
+*
+* Graph Glob
+*
+* Wildcard argument expanded while counting,
+* by pool tasks matching one directory each.
+*
+*/
+typedef struct jctl_graph_glob_s
+{
+	char *buf;					/* copy of the glob, split at the slashes */
+	jctl_uint n;				/* segment count */
+	jctl_uint absolute;			/* starts at the root directory */
+	jctl_graph_glob_seg *segs;	/* segments */
+} jctl_graph_glob;
+
+
+/*
+*
+* Graph Glob Task
+*
+* Directory whose names get matched
+* against a segment of a glob.
+*
+*/
+typedef struct jctl_graph_glob_task_s
+{
+	jctl_graph_glob *gl;	/* glob */
+	size_t len;				/* directory path length */
+	char path[];			/* directory path, "" for the working directory */
+} jctl_graph_glob_task;
+
+
+/*
+*
+* Graph Walk Task
+*
+* Directory to walk,
+* with the ignore rules of the directories above it.
+*
+*/
+typedef struct jctl_graph_walk_task_s
+{
+	jctl_ignore *ign;		/* ignore rules, NULL if none */
+	size_t len;				/* directory path length */
+	char path[];			/* directory path */
+} jctl_graph_walk_task;
+
+
+/*
+*
+* Graph Entry
+*
+*/
+typedef struct jctl_graph_entry_s
+{
+	char *fn;			/* filename */
+	jctl_uint wc;		/* uses wildcard */
+	jctl_size lc;		/* line count */
+	jctl_uint fnlen;	/* filename length */
+	jctl_uint dirlen;	/* directory length */
+	jctl_uint skip;		/* couldn't be read */
+	jctl_uint split;	/* counted in byte ranges */
+	jctl_uint cached;	/* line count taken from the cache */
+	jctl_file_info fi;	/* file information */
+	jctl_file_tail tail;	/* tail of the count, for the cache */
+	jctl_graph_dir *dir;	/* open directory of a walked file, NULL if none */
+} jctl_graph_entry;
+
+
+/*
+*
+* Graph Split
+*
+* Big file counted in byte ranges by several threads,
+* the line breaks of the ranges get summed up afterwards.
+*
+*/
+typedef struct jctl_graph_split_s
+{
+	jctl_graph_entry *e;	/* split entry */
+	jctl_uint n;			/* range count */
+	jctl_file_tail *tails;	/* line breaks and tail of each range */
+	jctl_uint *err;			/* error flag of each range */
+} jctl_graph_split;
+
+
+/*
+*
+* Graph Worker
+*
+* Every counting thread accumulates its own totals,
+* merged into the graph once all entries are counted.
+*
+*/
+typedef struct jctl_graph_worker_s
+{
+	struct jctl_graph_s *g;	/* graph */
+	jctl_file_buffer buf;	/* read buffer */
+	jctl_uring *uring;		/* io_uring backend, NULL if not used */
+	jctl_size glc;			/* line count */
+	jctl_uint hfnlen;		/* highest filename length */
+	jctl_uint hdirlen;		/* highest directory length */
+	jctl_arena names;		/* file names found by walkers and globs */
+	jctl_out out;			/* output lines, with '--stream' */
+	jctl_graph_entry *heap;	/* first counted entries in sort order, with '--top' */
+	jctl_uint heaptop;		/* heap entry count */
+	jctl_rollup rdirs;		/* lines by directory, with '--by-dir' */
+	jctl_rollup rexts;		/* lines by extension, with '--by-ext' */
+} jctl_graph_worker;
+
+
+/*
+*
+* Graph Context
+*
+* "Highest" values exist for printing the
+* padding in the 'jctl_graph_print' function.
+*
+* Directory walkers and the file list register entries while others
+* get counted, they push them in batches under 'lock'.
+*
+* With '--stream' and '--top' the files walkers and globs find
+* are counted in chunks of their own, freed right after
+* they are printed or offered to the heaps,
+* so memory doesn't grow with the amount of files.
+* So are they with '--by-dir' and '--by-ext', which only keep
+* the sums of the roll-ups.
+*
+*/
+typedef struct jctl_graph_s
+{
+	jmp_buf errbuf;				/* error buffer */
+	jctl_size glc;				/* global line count */
+	jctl_uint hfnlen;			/* highest filename length */
+	jctl_uint hdirlen;			/* highest directory length */
+	jctl_uint entrytop;			/* top entry index */
+	jctl_uint entrycap;			/* entries the blocks hold */
+	jctl_uint nblocks;			/* allocated entry blocks */
+	jctl_graph_entry *blocks[JCTL_GRAPH_ENTRY_BLOCKS];	/* entry store */
+	jctl_graph_entry *entries;	/* counted entries in one array, for sorting and printing */
+	jctl_arena names;			/* file names of all workers, once counted */
+	jctl_uint splittop;			/* top split index */
+	jctl_graph_split *splits;	/* split entries */
+	jctl_pool *pool;			/* counting thread pool */
+	jctl_graph_worker *workers;	/* counting thread totals */
+	jctl_cache *cache;			/* line count cache, NULL if not used */
+	jctl_filter *filter;		/* include and exclude patterns, NULL if none */
+	jctl_uint recursive;		/* walk directories, also those matched by globs */
+	jctl_uint ignore;			/* walkers honour ignore files */
+	jctl_uint roottop;			/* top root directory index */
+	jctl_uint rootcap;			/* root directory capacity */
+	char **roots;				/* directories to walk */
+	jctl_uint globtop;			/* top glob index */
+	jctl_uint globcap;			/* glob capacity */
+	jctl_graph_glob **globs;	/* globs to expand */
+	jctl_list *list;			/* file list read while counting, NULL if none */
+	pthread_mutex_t lock;		/* entry store and directory set lock */
+	pthread_mutex_t outlock;	/* output lock, with '--stream' */
+	atomic_int overflow;		/* a walker or glob ran out of entries, or a roll-up of memory */
+	atomic_uint dirsopen;		/* walked directories kept open */
+	jctl_set dirs;				/* walked directories */
+	jctl_set_shared files;		/* registered files */
+	jctl_uint stat;				/* walkers and globs stat the files they find */
+	jctl_uint remember;			/* walkers and globs register the files they find */
+	jctl_uint stream;			/* print files as they are counted */
+	jctl_graph_sortorder so;	/* sort order */
+	jctl_uint top;				/* entries kept by the heaps, 0 for all */
+	jctl_graph_sortorder keep;	/* order the heaps keep the first entries of */
+	jctl_uint drop;				/* counted entries aren't kept in the store */
+	atomic_uint streamfn;		/* name column width, with '--stream' */
+	atomic_uint streamlc;		/* line count column width, with '--stream' */
+	jctl_uint bydir;			/* sum up lines by directory */
+	jctl_uint dirdepth;			/* directory levels summed up, 0 for all */
+	jctl_uint byext;			/* sum up lines by extension */
+	jctl_rollup rdirs;			/* lines by directory of all workers */
+	jctl_rollup rexts;			/* lines by extension of all workers */
+	jctl_emit_format format;	/* output format */
+} jctl_graph;
+
+
+jctl_uint jctl_graph_run (ofp_state *S, jctl_graph_config *cfg);
+
+
+#endif /* JCTL_GRAPH_H */
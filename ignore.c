@@ -0,0 +1,478 @@
+#include "ignore.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+
+#ifdef _WIN32
+	#include <io.h>
+#else
+	#include <unistd.h>
+#endif
+
+/*
+ * Ignore files can be opened relative to an open directory.
+ */
+#ifndef _WIN32
+	#define JCTL_IGNORE_AT
+#endif
+
+#ifndef O_BINARY
+	#define O_BINARY (0)
+#endif
+
+#ifndef O_CLOEXEC
+	#define O_CLOEXEC (0)
+#endif
+
+
+/*
+ * Append ignore file 'name' of directory 'path' of length 'len',
+ * relative to its open file descriptor 'dirfd' unless it is -1,
+ * to the 'size' bytes of buffer 'buf' holding 'cap',
+ * followed by a newline so the next one starts on a line of its own.
+ * Missing or unreadable ignore files are skipped.
+ * Return 0 on success, 1 if out of memory.
+ */
+static jctl_uint jctl_ignore_read (char **buf, size_t *size, size_t *cap, int dirfd, const char *path, size_t len, const char *name)
+{
+	int fd = -1;
+#ifdef JCTL_IGNORE_AT
+	if(dirfd >= 0)
+		fd = openat(dirfd, name, O_RDONLY | O_CLOEXEC);
+	else
+#endif /* defined(JCTL_IGNORE_AT) */
+	{
+		size_t namelen = strlen(name);
+		char *fn = (char*)malloc(len + namelen + 2);
+		if(fn == NULL)
+			return 1;
+		memcpy(fn, path, len);
+		fn[len] = '/';
+		memcpy(fn + len + (len > 0 && path[len - 1] != '/'), name, namelen + 1);
+		fd = open(fn, O_RDONLY | O_BINARY | O_CLOEXEC);
+		free(fn);
+	}
+	if(fd < 0)
+		return 0;
+
+	size_t start = *size;
+	jctl_uint err = 0;
+	for(;;)
+	{
+		/* room for the newline and the terminator */
+		if(*cap - *size < 3)
+		{
+			size_t ncap = (*cap == 0) ? 4096 : *cap * 2;
+			char *nbuf = (char*)realloc(*buf, ncap);
+			if(nbuf == NULL)
+			{
+				err = 1;
+				break;
+			}
+			*buf = nbuf;
+			*cap = ncap;
+		}
+
+		long long n = read(fd, *buf + *size, (unsigned int)(*cap - *size - 2));
+		if(n < 0 && errno == EINTR)
+			continue;
+		if(n < 0)
+			*size = start;
+		if(n <= 0)
+			break;
+		*size += (size_t) n;
+	}
+	close(fd);
+
+	if(!err && *size > start)
+		(*buf)[(*size)++] = '\n';
+	return err;
+}
+
+
+/*
+ * Split the pattern 'p' of a rule with a slash into the segments
+ * of rule 'r' in place, and compile them.
+ * A trailing "**" matches everything below, but not the directory
+ * before it, so it is followed by a segment matching any name.
+ * Return 0 on success, 1 if out of memory.
+ */
+static jctl_uint jctl_ignore_segs (jctl_ignore_rule *r, char *p)
+{
+	size_t n = 2;
+	for(char *q = p; *q != '\0'; ++q)
+		n += (*q == '/');
+
+	r->segs = (jctl_ignore_seg*)calloc(n, sizeof(*r->segs));
+	if(r->segs == NULL)
+		return 1;
+
+	for(char *s = p, *end; s != NULL; s = end)
+	{
+		end = strchr(s, '/');
+		if(end != NULL)
+			*end++ = '\0';
+
+		/* "a//b" is "a/b", consecutive "**" are the same as one */
+		if(*s == '\0')
+			continue;
+		jctl_uint any = (strcmp(s, "**") == 0);
+		if(any && r->nsegs > 0 && r->segs[r->nsegs - 1].any)
+			continue;
+
+		jctl_ignore_seg *seg = r->segs + r->nsegs++;
+		seg->any = any;
+		if(!any && wc_compile(&seg->dfa, s))
+			return 1;
+	}
+
+	if(r->nsegs > 0 && r->segs[r->nsegs - 1].any)
+	{
+		jctl_ignore_seg *seg = r->segs + r->nsegs++;
+		if(wc_compile(&seg->dfa, "*"))
+			return 1;
+	}
+
+	return 0;
+}
+
+
+/*
+ * Parse the lines of the ignore files in the buffer of 'ign' into its rules,
+ * in the syntax of '.gitignore': blank lines and those starting with "#"
+ * are skipped, trailing spaces are dropped unless escaped with "\",
+ * a leading "!" negates a rule and a trailing "/" makes it only
+ * match directories. A rule with a slash, but for a trailing one,
+ * matches paths relative to the directory, a leading slash only
+ * anchors it there. A leading "**" followed by a single name
+ * matches that name at any depth, like a rule without a slash.
+ * Classes are negated by "[!...]" as well as by "[^...]".
+ * Return 0 on success, 1 if out of memory.
+ */
+static jctl_uint jctl_ignore_parse (jctl_ignore *ign, size_t size)
+{
+	size_t lines = 1;
+	for(size_t i = 0; i < size; ++i)
+		lines += (ign->buf[i] == '\n');
+
+	ign->rules = (jctl_ignore_rule*)calloc(lines, sizeof(*ign->rules));
+	ign->dirrules = (int*)malloc(lines * sizeof(*ign->dirrules));
+	ign->filerules = (int*)malloc(lines * sizeof(*ign->filerules));
+	ign->paths = (jctl_uint*)malloc(lines * sizeof(*ign->paths));
+	const char **dirpats = (const char**)malloc(lines * sizeof(*dirpats));
+	const char **filepats = (const char**)malloc(lines * sizeof(*filepats));
+	jctl_uint err = (ign->rules == NULL || ign->dirrules == NULL || ign->filerules == NULL
+		|| ign->paths == NULL || dirpats == NULL || filepats == NULL);
+
+	char *next = ign->buf;
+	char *bufend = ign->buf + size;
+	while(!err && next < bufend)
+	{
+		char *p = next;
+		char *end = (char*)memchr(p, '\n', bufend - p);
+		if(end == NULL)
+			end = bufend;
+		next = end + 1;
+
+		if(end > p && end[-1] == '\r')
+			--end;
+		while(end > p && end[-1] == ' ' && !(end - 1 > p && end[-2] == '\\'))
+			--end;
+		*end = '\0';
+		if(*p == '\0' || *p == '#')
+			continue;
+
+		/* the slot of a skipped rule gets reused */
+		jctl_ignore_rule *r = ign->rules + ign->n;
+		r->negate = 0;
+		r->dironly = 0;
+		if(*p == '!')
+		{
+			r->negate = 1;
+			++p;
+		}
+		while(end > p && end[-1] == '/')
+		{
+			r->dironly = 1;
+			*--end = '\0';
+		}
+
+		for(char *q = p; *q != '\0'; ++q)
+		{
+			if(*q == '\\' && q[1] != '\0')
+				++q;
+			else if(*q == '[' && q[1] == '!')
+				q[1] = '^';
+		}
+
+		jctl_uint anchored = (strchr(p, '/') != NULL);
+		if(*p == '/')
+			++p;
+		while(anchored && strncmp(p, "**/", 3) == 0 && strchr(p + 3, '/') == NULL)
+		{
+			p += 3;
+			anchored = 0;
+		}
+		if(*p == '\0')
+			continue;
+
+		if(anchored)
+		{
+			err = jctl_ignore_segs(r, p);
+			ign->paths[ign->npaths++] = ign->n;
+		}
+		else
+		{
+			ign->dirrules[ign->ndirs] = (int) ign->n;
+			dirpats[ign->ndirs++] = p;
+			if(!r->dironly)
+			{
+				ign->filerules[ign->nfiles] = (int) ign->n;
+				filepats[ign->nfiles++] = p;
+			}
+		}
+		++ign->n;
+	}
+
+	if(!err && ign->ndirs > 0)
+		err = wc_compile_set(&ign->dirs, dirpats, (int) ign->ndirs);
+	if(!err && ign->nfiles > 0)
+		err = wc_compile_set(&ign->files, filepats, (int) ign->nfiles);
+
+	free(dirpats);
+	free(filepats);
+	return err;
+}
+
+
+/*
+ * Free the rules of 'ign', but not those above it.
+ */
+static void jctl_ignore_free (jctl_ignore *ign)
+{
+	for(jctl_uint i = 0; ign->rules != NULL && i < ign->n; ++i)
+	{
+		jctl_ignore_rule *r = ign->rules + i;
+		for(jctl_uint k = 0; r->segs != NULL && k < r->nsegs; ++k)
+			wc_free(&r->segs[k].dfa);
+		free(r->segs);
+	}
+	wc_free(&ign->dirs);
+	wc_free(&ign->files);
+	free(ign->rules);
+	free(ign->dirrules);
+	free(ign->filerules);
+	free(ign->paths);
+	free(ign->buf);
+	free(ign);
+}
+
+
+/*
+ * Read the ignore files of directory 'path' of length 'len',
+ * open as 'dirfd' unless it is -1, into rules on top of 'parent'
+ * (NULL for none) returned in 'ign', referenced once.
+ * Without any rules that is 'parent', referenced once more.
+ * Return 0 on success, 1 if out of memory.
+ */
+jctl_uint jctl_ignore_load (jctl_ignore **ign, jctl_ignore *parent, int dirfd, const char *path, size_t len)
+{
+	static const char *names[JCTL_IGNORE_NFILES] = JCTL_IGNORE_FILES;
+
+	*ign = NULL;
+
+	char *buf = NULL;
+	size_t size = 0;
+	size_t cap = 0;
+	for(jctl_uint i = 0; i < JCTL_IGNORE_NFILES; ++i)
+	{
+		if(jctl_ignore_read(&buf, &size, &cap, dirfd, path, len, names[i]))
+		{
+			free(buf);
+			return 1;
+		}
+	}
+
+	if(size == 0)
+	{
+		free(buf);
+		*ign = jctl_ignore_retain(parent);
+		return 0;
+	}
+
+	jctl_ignore *n = (jctl_ignore*)calloc(1, sizeof(*n));
+	if(n == NULL)
+	{
+		free(buf);
+		return 1;
+	}
+	n->buf = buf;
+	n->base = len + (path[len - 1] != '/');
+	atomic_init(&n->refs, 1);
+
+	if(jctl_ignore_parse(n, size))
+	{
+		jctl_ignore_free(n);
+		return 1;
+	}
+
+	/* only comments and blank lines */
+	if(n->n == 0)
+	{
+		jctl_ignore_free(n);
+		*ign = jctl_ignore_retain(parent);
+		return 0;
+	}
+
+	n->parent = jctl_ignore_retain(parent);
+	*ign = n;
+	return 0;
+}
+
+
+/*
+ * Add a reference to rules 'ign', which may be NULL.
+ * Return 'ign'.
+ */
+jctl_ignore *jctl_ignore_retain (jctl_ignore *ign)
+{
+	if(ign != NULL)
+		atomic_fetch_add(&ign->refs, 1);
+	return ign;
+}
+
+
+/*
+ * Drop a reference to rules 'ign', which may be NULL,
+ * the last one frees them and drops theirs to the rules above.
+ */
+void jctl_ignore_release (jctl_ignore *ign)
+{
+	while(ign != NULL && atomic_fetch_sub(&ign->refs, 1) == 1)
+	{
+		jctl_ignore *parent = ign->parent;
+		jctl_ignore_free(ign);
+		ign = parent;
+	}
+}
+
+
+/*
+ * Return the offset of the path component after the one at offset 'p'
+ * of relative directory 'rel' of length 'rellen' followed by 'name',
+ * and the component in 'c' and 'clen'.
+ * Offset 'rellen + 1' is the one of 'name', past it there are none.
+ */
+static inline size_t jctl_ignore_component (const char *rel, size_t rellen, const char *name, size_t namelen, size_t p, const char **c, size_t *clen)
+{
+	if(p == rellen + 1)
+	{
+		*c = name;
+		*clen = namelen;
+		return p + 1;
+	}
+
+	*c = rel + p;
+	const char *q = (const char*)memchr(*c, '/', rellen - p);
+	if(q == NULL)
+	{
+		*clen = rellen - p;
+		return rellen + 1;
+	}
+	*clen = (size_t)(q - *c);
+	return p + *clen + 1;
+}
+
+
+/*
+ * Return 1 if the 'n' segments 's' match the path components
+ * from offset 'p' on, see 'jctl_ignore_component', otherwise return 0.
+ */
+static int jctl_ignore_segs_match (const jctl_ignore_seg *s, jctl_uint n, const char *rel, size_t rellen, const char *name, size_t namelen, size_t p)
+{
+	const char *c;
+	size_t clen;
+
+	for(; n > 0; ++s, --n)
+	{
+		if(p > rellen + 1)
+			return 0;
+
+		/* any amount of components, even none */
+		if(s->any)
+		{
+			for(;;)
+			{
+				if(jctl_ignore_segs_match(s + 1, n - 1, rel, rellen, name, namelen, p))
+					return 1;
+				if(p > rellen + 1)
+					return 0;
+				p = jctl_ignore_component(rel, rellen, name, namelen, p, &c, &clen);
+			}
+		}
+
+		p = jctl_ignore_component(rel, rellen, name, namelen, p, &c, &clen);
+		if(wc_dfa_match(&s->dfa, c, clen) <= 0)
+			return 0;
+	}
+
+	return (p > rellen + 1);
+}
+
+
+/*
+ * Return 1 if file or directory ('dir') 'name' of length 'namelen'
+ * in walked directory 'path' of length 'len' is ignored by the rules
+ * 'ign', otherwise return 0.
+ * The last rule matching it decides, those of deeper directories
+ * come before those above them, it is not ignored if none does.
+ */
+jctl_uint jctl_ignore_match (const jctl_ignore *ign, const char *path, size_t len, const char *name, size_t namelen, jctl_uint dir)
+{
+	for(; ign != NULL; ign = ign->parent)
+	{
+		int hit = -1;
+		if(dir && ign->ndirs > 0)
+		{
+			int i = wc_dfa_find(&ign->dirs, name, namelen);
+			if(i >= 0)
+				hit = ign->dirrules[i];
+		}
+		else if(!dir && ign->nfiles > 0)
+		{
+			int i = wc_dfa_find(&ign->files, name, namelen);
+			if(i >= 0)
+				hit = ign->filerules[i];
+		}
+
+		/* rules with segments only matter if they come later */
+		if(ign->npaths > 0 && (int) ign->paths[ign->npaths - 1] > hit)
+		{
+			const char *rel = path;
+			size_t rellen = 0;
+			if(len > ign->base)
+			{
+				rel = path + ign->base;
+				rellen = len - ign->base;
+			}
+
+			for(jctl_uint k = ign->npaths; k-- > 0 && (int) ign->paths[k] > hit; )
+			{
+				const jctl_ignore_rule *r = ign->rules + ign->paths[k];
+				if(r->dironly && !dir)
+					continue;
+				if(jctl_ignore_segs_match(r->segs, r->nsegs, rel, rellen, name, namelen, (rellen > 0) ? 0 : rellen + 1))
+				{
+					hit = (int) ign->paths[k];
+					break;
+				}
+			}
+		}
+
+		if(hit >= 0)
+			return !ign->rules[hit].negate;
+	}
+
+	return 0;
+}
@@ -0,0 +1,91 @@
+#ifndef JCTL_IGNORE_H
+#define JCTL_IGNORE_H
+
+#include "jctl.h"
+#include "wildcard.h"
+#include <stddef.h>
+#include <stdatomic.h>
+
+
+/*
+ * Ignore files read in every walked directory, in order of precedence,
+ * the rules of a later one win over those of an earlier one.
+ */
+#define JCTL_IGNORE_FILES	{ ".gitignore", ".ignore", ".jctlignore" }
+#define JCTL_IGNORE_NFILES	(3)
+
+
+/*
+*
+* Ignore Segment
+*
+* Path component of a rule with a slash, "**" matches any amount of them.
+*
+*/
+typedef struct jctl_ignore_seg_s
+{
+	jctl_uint any;		/* "**" */
+	wc_dfa dfa;			/* compiled wildcard, unless 'any' */
+} jctl_ignore_seg;
+
+
+/*
+*
+* Ignore Rule
+*
+* A line of an ignore file, in the syntax of '.gitignore'.
+* Rules without a slash match the name of a file or directory
+* at any depth, those with one its path relative to the directory
+* of the ignore file, one component per segment.
+*
+*/
+typedef struct jctl_ignore_rule_s
+{
+	jctl_uint negate;			/* "!": matches are not ignored */
+	jctl_uint dironly;			/* trailing "/": only matches directories */
+	jctl_uint nsegs;			/* segment count, 0 for a rule matching names */
+	jctl_ignore_seg *segs;		/* path segments */
+} jctl_ignore_rule;
+
+
+/*
+*
+* Ignore Rules
+*
+* Rules of the ignore files of a walked directory,
+* on top of those of the directories above it.
+* The rules matching names are compiled into two automatons,
+* one for directories and one for files, without the rules
+* that only match directories, both telling the last rule
+* that matches.
+*
+* Shared by the walkers of the directories below it,
+* the last one to release it frees it.
+*
+*/
+typedef struct jctl_ignore_s
+{
+	struct jctl_ignore_s *parent;	/* rules of the directories above, NULL if none */
+	atomic_uint refs;				/* walkers still using it */
+	size_t base;					/* offset of paths relative to its directory */
+	char *buf;						/* ignore files, the patterns point into it */
+	jctl_uint n;					/* rule count */
+	jctl_ignore_rule *rules;		/* rules in order of precedence */
+	wc_dfa dirs;					/* name rules matching directories */
+	int *dirrules;					/* rule of every wildcard of 'dirs' */
+	jctl_uint ndirs;				/* wildcards of 'dirs' */
+	wc_dfa files;					/* name rules matching files */
+	int *filerules;					/* rule of every wildcard of 'files' */
+	jctl_uint nfiles;				/* wildcards of 'files' */
+	jctl_uint *paths;				/* rules with segments */
+	jctl_uint npaths;				/* rules with segments count */
+} jctl_ignore;
+
+
+jctl_uint	jctl_ignore_load	(jctl_ignore **ign, jctl_ignore *parent, int dirfd, const char *path, size_t len);
+jctl_ignore*	jctl_ignore_retain	(jctl_ignore *ign);
+void		jctl_ignore_release	(jctl_ignore *ign);
+jctl_uint	jctl_ignore_match	(const jctl_ignore *ign, const char *path, size_t len, const char *name, size_t namelen, jctl_uint dir);
+
+
+#endif /* JCTL_IGNORE_H */
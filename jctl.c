@@ -1,195 +1,528 @@
-#include "ofp/ofp.h"
-#include "ofp/state.h"
-#include "ofp/argument.h"
-#include "graph.h"
-#include "file.h"
-#include "jctl.h"
-#include <stdlib.h>
-#include <stdio.h>
-#include <string.h>
-#include <stdarg.h>
-
-
-/*
-*
-* Handle OFP UDA error
-*
-*/
-void arg_error (ofp_argument *arg, ofp_errorcode ec)
-{
-	_jctl_printf("jctl: error: ");
-    switch(ec)
-    {
-    case OFP_ERR_ARG_REQ:
-        _jctl_printf("required command line option '-%s'", arg->id);
-        break;
-    case OFP_ERR_ARG_NOVAL:
-        _jctl_printf("command line option '-%s' requires a value", arg->id);
-        break;
-    }
-    _jctl_printf("\n");
-}
-
-
-/*
-*
-* Print JCTL usage
-*
-*/
-void print_usage (char **argv)
-{
-	_jctl_printf
-	(
-		"Usage: %s [-o[nlL]] names\n"
-		"\n"
-		"  names       Specifies a list of one or more files.\n"
-		"              Wildcards are supported.\n"
-		"\n"
-		"  -o          List by files in sorted order\n"
-		"  sortorder     n : By name (alphabetical)\n"
-		"                l : By line count (increasing)\n"
-		"                L : By line count (decreasing)\n"
-		"\n",
-		*argv
-	);
-}
-
-
-void print_error (char *err)
-{
-	_jctl_printf("jctl: error: %s\n", err);
-}
-
-
-/*
-*
-* Print an JCTL error
-* using variable arguments
-*
-*/
-void vprintf_error (char *fmt, ...)
-{
-	va_list arg;
-	va_start(arg, fmt);
-	_jctl_printf("jctl: error: ");
-	vprintf(fmt, arg);
-	_jctl_printf("\n");
-	va_end(arg);
-}
-
-
-/*
-*
-* Main program entry
-*
-*/
-int main (int argc, char **argv)
-{
-	if(argc == 1)
-	{
-		print_usage(argv);
-		return EXIT_SUCCESS;
-	}
-
-	/*
-	*
-	* OFP State Initialization
-	*
-	*/
-
-	ofp_state *S = ofp_state_new(argv + 1, argc - 1, OFP_ARG_PRTY_FIRST, 1);
-
-	if(S == NULL)
-	{
-		print_error("out of memory");
-		return EXIT_FAILURE;
-	}
-
-	S->p = '-';
-	ofp_argument *arg_sortorder;
-
-	/*
-	*
-	* OFP Fatal Error
-	*
-	*/
-
-	ofp_on_ferror(S)
-	{
-		_jctl_printf("jctl: fatal error: 0x%02X\n", S->ferr);
-        goto clean_up;
-	}
-
-	/*
-	*
-	* OFP Argument Definition
-	*
-	*/
-
-	arg_sortorder = ofp_argument_register(S, OFP_ARG_TYPE_SUIA_OPTION, OFP_ARG_PRTY_INHERIT, OFP_ARG_NOT_REQUIRED, arg_error, "o", 1, NULL);
-	ofp_parser_parse(S);
-
-	/*
-	*
-	* JCTL Error Checking
-	*
-	*/
-
-	int exit = 0;
-
-	if(S->uuiac > 0)
-	{
-		for(int i = 0; i < S->uuialt; ++i)
-		{
-			if(S->uuial[i] != NULL)
-			{
-				exit = 1;
-				_jctl_printf("jctl: error: unrecognized command line option '-%s'\n", S->uuial[i]);
-			}
-		}
-	}
-
-	if(S->nac == 0)
-	{
-		_jctl_printf("jctl: fatal error: no input files");
-		exit = 1;
-	}
-
-	if(exit || ofp_any_error(S))
-		goto clean_up;
-
-	/*
-	*
-	* JCTL Output
-	*
-	*/
-
-	jctl_graph_sortorder so = ofp_option_enumval(arg_sortorder, 3,
-		"n", 1, JCTL_GRAPH_SORT_NAME,
-		"l", 1, JCTL_GRAPH_SORT_LINE_INC,
-		"L", 1, JCTL_GRAPH_SORT_LINE_DEC
-	);
-
-	if(so == -1)
-	{
-		vprintf_error("undefined sortorder '%s' for argument '-%s'", arg_sortorder->v.o, arg_sortorder->id);
-		_jctl_printf("jctl: error: undefined sortorder '%s' for argument '-%s'\n", arg_sortorder->v.o, arg_sortorder->id);
-		goto clean_up;
-	}
-
-	if(jctl_graph_run(S, so))
-	{
-		_jctl_printf("jctl: error: out of memory\n");
-	}
-
-	/*
-	*
-	* JCTL Clean-Up
-	*
-	*/
-
-clean_up:
-	ofp_state_free(S);
-
-	return EXIT_SUCCESS;
+#include "ofp/ofp.h"
+#include "ofp/state.h"
+#include "ofp/argument.h"
+#include "graph.h"
+#include "file.h"
+#include "count.h"
+#include "pool.h"
+#include "filter.h"
+#include "jctl.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+
+
+/*
+*
+* Handle OFP UDA error
+*
+*/
+void arg_error (ofp_argument *arg, ofp_errorcode ec)
+{
+	_jctl_printf("jctl: error: ");
+    switch(ec)
+    {
+    case OFP_ERR_ARG_REQ:
+        _jctl_printf("required command line option '-%s'", arg->id);
+        break;
+    case OFP_ERR_ARG_NOVAL:
+        _jctl_printf("command line option '-%s' requires a value", arg->id);
+        break;
+    }
+    _jctl_printf("\n");
+}
+
+
+/*
+*
+* Print JCTL usage
+*
+*/
+void print_usage (char **argv)
+{
+	_jctl_printf
+	(
+		"Usage: %s [-o[nlL]] [-r [--no-ignore]] [-b size] [-j jobs] [--uring] [--cache]\n"
+		"          [--include patterns] [--exclude patterns] [--stream]\n"
+		"          [--top count | --bottom count] [--by-dir[=depth]] [--by-ext]\n"
+		"          [--format=format] [--save-snapshot file]\n"
+		"          [--files-from file | --files0-from file] names\n"
+		"       %s --diff old new\n"
+		"\n"
+		"  names       Specifies a list of one or more files.\n"
+		"              Wildcards are supported.\n"
+		"              With -r directories are counted recursively.\n"
+		"\n"
+		"  -o          List by files in sorted order\n"
+		"  sortorder     n : By name (alphabetical)\n"
+		"                l : By line count (increasing)\n"
+		"                L : By line count (decreasing)\n"
+		"\n"
+		"  -r          Walk directories recursively, without following\n"
+		"              symbolic links, skipping the files and directories\n"
+		"              ignored by .gitignore, .ignore and .jctlignore files\n"
+		"              and .git directories\n"
+		"  --no-ignore Walk ignored files and directories too\n"
+		"  -b          Read buffer size in KiB (%u - %u, default %u)\n"
+		"  -j          Amount of counting threads (default: CPUs available)\n"
+		"  --uring     Read small files in batches with io_uring (Linux)\n"
+		"  --cache     Reuse line counts of unchanged files from earlier runs\n"
+		"              and only count what got appended to grown files,\n"
+		"              kept in $XDG_CACHE_HOME/jctl/index (~/.cache/jctl/index)\n"
+		"  --include   Only count files whose name matches one of\n"
+		"              the comma separated wildcards, like \"*.c,*.h\"\n"
+		"  --exclude   Skip files whose name matches one of\n"
+		"              the comma separated wildcards, even if included\n"
+		"  --stream    Print every file as soon as it is counted, unsorted\n"
+		"              and without graph, then the total, in constant memory\n"
+		"  --top       Only list the given amount of files with the most lines,\n"
+		"              in the order of -o (default: -oL)\n"
+		"  --bottom    Only list the given amount of files with the least lines,\n"
+		"              in the order of -o (default: -ol)\n"
+		"  --by-dir    List the lines of every directory, including the ones\n"
+		"              below it, instead of the files, with =depth only\n"
+		"              the given amount of directory levels\n"
+		"  --by-ext    List the lines of every file extension instead of the files\n"
+		"              (both are listed after the files with --stream, --top\n"
+		"              and --bottom)\n"
+		"  --format    Output format of the files, a record per file\n"
+		"              with path, lines, bytes and directory length\n"
+		"  format        text  : Graph (default)\n"
+		"                jsonl : JSON object per line\n"
+		"                csv   : Comma separated values, with header row\n"
+		"                bin   : Length prefixed binary records (see emit.h)\n"
+		"  --save-snapshot  Save the counted files to the given file, for --diff\n"
+		"  --files-from   Also count the names listed in the given file,\n"
+		"                 one per line, \"-\" reads them from standard input\n"
+		"  --files0-from  Like --files-from, with names separated by NUL\n"
+		"                 (find -print0, git ls-files -z)\n"
+		"  --diff      Compare snapshot old to the later snapshot new: list\n"
+		"              added, removed and changed files and the line deltas\n"
+		"              of every directory, without counting anything\n"
+		"\n",
+		*argv, *argv,
+		JCTL_FILE_BUFSIZE_MIN / 1024, JCTL_FILE_BUFSIZE_MAX / 1024, JCTL_FILE_BUFSIZE_DEFAULT / 1024
+	);
+}
+
+
+void print_error (char *err)
+{
+	_jctl_printf("jctl: error: %s\n", err);
+}
+
+
+/*
+*
+* Print an JCTL error
+* using variable arguments
+*
+*/
+void vprintf_error (char *fmt, ...)
+{
+	va_list arg;
+	va_start(arg, fmt);
+	_jctl_printf("jctl: error: ");
+	vprintf(fmt, arg);
+	_jctl_printf("\n");
+	va_end(arg);
+}
+
+
+/*
+*
+* Read the unsigned integer value of option 'arg' into 'v'.
+* Return 0 if it's a number in range of 'min' to 'max',
+* otherwise print an error and return 1.
+*
+*/
+int option_uint (ofp_argument *arg, unsigned long min, unsigned long max, unsigned long *v)
+{
+	char *end;
+	unsigned long n = strtoul(arg->v.o, &end, 10);
+
+	if(end == arg->v.o || *end != '\0' || n < min || n > max)
+	{
+		vprintf_error("invalid value '%s' for argument '-%s', expected %lu to %lu", arg->v.o, arg->id, min, max);
+		return 1;
+	}
+
+	*v = n;
+	return 0;
+}
+
+
+/*
+*
+* Main program entry
+*
+*/
+int main (int argc, char **argv)
+{
+	if(argc == 1)
+	{
+		print_usage(argv);
+		return EXIT_SUCCESS;
+	}
+
+	/*
+	*
+	* Line Counting Setup
+	*
+	*/
+
+	jctl_count_setup();
+	jctl_file_setup();
+
+	/*
+	*
+	* OFP State Initialization
+	*
+	*/
+
+	ofp_state *S = ofp_state_new(argv + 1, argc - 1, OFP_ARG_PRTY_FIRST, 1);
+
+	if(S == NULL)
+	{
+		print_error("out of memory");
+		return EXIT_FAILURE;
+	}
+
+	S->p = '-';
+	ofp_argument *arg_sortorder;
+	ofp_argument *arg_recursive;
+	ofp_argument *arg_noignore;
+	ofp_argument *arg_bufsize;
+	ofp_argument *arg_jobs;
+	ofp_argument *arg_uring;
+	ofp_argument *arg_cache;
+	ofp_argument *arg_include;
+	ofp_argument *arg_exclude;
+	ofp_argument *arg_stream;
+	ofp_argument *arg_top;
+	ofp_argument *arg_bottom;
+	ofp_argument *arg_bydir;
+	ofp_argument *arg_byext;
+	ofp_argument *arg_format;
+	ofp_argument *arg_snapshot;
+	ofp_argument *arg_diff;
+	ofp_argument *arg_filesfrom;
+	ofp_argument *arg_files0from;
+	jctl_filter filter;
+	jctl_uint filtered = 0;
+	jctl_list list;
+	jctl_uint listed = 0;
+	const char *listfn = NULL;
+
+	/*
+	*
+	* OFP Fatal Error
+	*
+	*/
+
+	ofp_on_ferror(S)
+	{
+		_jctl_printf("jctl: fatal error: 0x%02X\n", S->ferr);
+        goto clean_up;
+	}
+
+	/*
+	*
+	* OFP Argument Definition
+	*
+	*/
+
+	arg_sortorder = ofp_argument_register(S, OFP_ARG_TYPE_SUIA_OPTION, OFP_ARG_PRTY_INHERIT, OFP_ARG_NOT_REQUIRED, arg_error, "o", 1, NULL);
+	arg_recursive = ofp_argument_register(S, OFP_ARG_TYPE_FLAG, OFP_ARG_PRTY_INHERIT, OFP_ARG_NOT_REQUIRED, arg_error, "r", 1, NULL);
+	arg_noignore  = ofp_argument_register(S, OFP_ARG_TYPE_FLAG, OFP_ARG_PRTY_INHERIT, OFP_ARG_NOT_REQUIRED, arg_error, "-no-ignore", 10, NULL);
+	arg_bufsize   = ofp_argument_register(S, OFP_ARG_TYPE_DUIA_OPTION, OFP_ARG_PRTY_INHERIT, OFP_ARG_NOT_REQUIRED, arg_error, "b", 1, NULL);
+	arg_jobs      = ofp_argument_register(S, OFP_ARG_TYPE_DUIA_OPTION, OFP_ARG_PRTY_INHERIT, OFP_ARG_NOT_REQUIRED, arg_error, "j", 1, NULL);
+	arg_uring     = ofp_argument_register(S, OFP_ARG_TYPE_FLAG, OFP_ARG_PRTY_INHERIT, OFP_ARG_NOT_REQUIRED, arg_error, "-uring", 6, NULL);
+	arg_cache     = ofp_argument_register(S, OFP_ARG_TYPE_FLAG, OFP_ARG_PRTY_INHERIT, OFP_ARG_NOT_REQUIRED, arg_error, "-cache", 6, NULL);
+	arg_include   = ofp_argument_register(S, OFP_ARG_TYPE_DUIA_OPTION, OFP_ARG_PRTY_INHERIT, OFP_ARG_NOT_REQUIRED, arg_error, "-include", 8, NULL);
+	arg_exclude   = ofp_argument_register(S, OFP_ARG_TYPE_DUIA_OPTION, OFP_ARG_PRTY_INHERIT, OFP_ARG_NOT_REQUIRED, arg_error, "-exclude", 8, NULL);
+	arg_stream    = ofp_argument_register(S, OFP_ARG_TYPE_FLAG, OFP_ARG_PRTY_INHERIT, OFP_ARG_NOT_REQUIRED, arg_error, "-stream", 7, NULL);
+	arg_top       = ofp_argument_register(S, OFP_ARG_TYPE_DUIA_OPTION, OFP_ARG_PRTY_INHERIT, OFP_ARG_NOT_REQUIRED, arg_error, "-top", 4, NULL);
+	arg_bottom    = ofp_argument_register(S, OFP_ARG_TYPE_DUIA_OPTION, OFP_ARG_PRTY_INHERIT, OFP_ARG_NOT_REQUIRED, arg_error, "-bottom", 7, NULL);
+	arg_bydir     = ofp_argument_register(S, OFP_ARG_TYPE_SUIA_OPTION, OFP_ARG_PRTY_INHERIT, OFP_ARG_NOT_REQUIRED, arg_error, "-by-dir", 7, NULL);
+	arg_byext     = ofp_argument_register(S, OFP_ARG_TYPE_FLAG, OFP_ARG_PRTY_INHERIT, OFP_ARG_NOT_REQUIRED, arg_error, "-by-ext", 7, NULL);
+	arg_format    = ofp_argument_register(S, OFP_ARG_TYPE_SUIA_OPTION, OFP_ARG_PRTY_INHERIT, OFP_ARG_NOT_REQUIRED, arg_error, "-format", 7, NULL);
+	arg_snapshot  = ofp_argument_register(S, OFP_ARG_TYPE_DUIA_OPTION, OFP_ARG_PRTY_INHERIT, OFP_ARG_NOT_REQUIRED, arg_error, "-save-snapshot", 14, NULL);
+	arg_diff      = ofp_argument_register(S, OFP_ARG_TYPE_DUIA_OPTION, OFP_ARG_PRTY_INHERIT, OFP_ARG_NOT_REQUIRED, arg_error, "-diff", 5, NULL);
+	arg_filesfrom = ofp_argument_register(S, OFP_ARG_TYPE_DUIA_OPTION, OFP_ARG_PRTY_INHERIT, OFP_ARG_NOT_REQUIRED, arg_error, "-files-from", 11, NULL);
+	arg_files0from = ofp_argument_register(S, OFP_ARG_TYPE_DUIA_OPTION, OFP_ARG_PRTY_INHERIT, OFP_ARG_NOT_REQUIRED, arg_error, "-files0-from", 12, NULL);
+	ofp_parser_parse(S);
+
+	/*
+	*
+	* JCTL Error Checking
+	*
+	*/
+
+	int exit = 0;
+
+	if(S->uuiac > 0)
+	{
+		for(int i = 0; i < S->uuialt; ++i)
+		{
+			if(S->uuial[i] != NULL)
+			{
+				exit = 1;
+				_jctl_printf("jctl: error: unrecognized command line option '-%s'\n", S->uuial[i]);
+			}
+		}
+	}
+
+	if(S->nac == 0 && !arg_filesfrom->i && !arg_files0from->i)
+	{
+		_jctl_printf("jctl: fatal error: no input files");
+		exit = 1;
+	}
+
+	if(exit || ofp_any_error(S))
+		goto clean_up;
+
+	/*
+	*
+	* JCTL Snapshot Diff
+	*
+	*/
+
+	if(arg_diff->i)
+	{
+		if(S->nac != 1 || arg_snapshot->i)
+		{
+			print_error("'--diff' compares snapshot old to a single snapshot new, it can't be combined with '--save-snapshot'");
+			goto clean_up;
+		}
+
+		char *newfn = NULL;
+		for(ofp_uint i = 0; i < S->nalt && newfn == NULL; ++i)
+			newfn = S->nal[i];
+
+		jctl_snap from, to;
+		if(jctl_snap_open(&from, arg_diff->v.o))
+		{
+			vprintf_error("can't read snapshot '%s'", arg_diff->v.o);
+			goto clean_up;
+		}
+		if(jctl_snap_open(&to, newfn))
+		{
+			vprintf_error("can't read snapshot '%s'", newfn);
+			jctl_snap_close(&from);
+			goto clean_up;
+		}
+
+		jctl_out o;
+		jctl_uint err = 1;
+		fflush(stdout);
+		if(!jctl_out_init(&o, fileno(stdout), JCTL_OUT_BUFSIZE))
+		{
+			err = jctl_snap_diff(&from, &to, &o);
+			jctl_out_flush(&o);
+			jctl_out_free(&o);
+		}
+
+		if(err == 1)
+			print_error("out of memory");
+		else if(err)
+			vprintf_error("snapshot '%s' is damaged", from.err ? arg_diff->v.o : newfn);
+
+		jctl_snap_close(&from);
+		jctl_snap_close(&to);
+		goto clean_up;
+	}
+
+	/*
+	*
+	* JCTL Output
+	*
+	*/
+
+	jctl_graph_sortorder so = ofp_option_enumval(arg_sortorder, 3,
+		"n", 1, JCTL_GRAPH_SORT_NAME,
+		"l", 1, JCTL_GRAPH_SORT_LINE_INC,
+		"L", 1, JCTL_GRAPH_SORT_LINE_DEC
+	);
+
+	if(so == -1)
+	{
+		vprintf_error("undefined sortorder '%s' for argument '-%s'", arg_sortorder->v.o, arg_sortorder->id);
+		_jctl_printf("jctl: error: undefined sortorder '%s' for argument '-%s'\n", arg_sortorder->v.o, arg_sortorder->id);
+		goto clean_up;
+	}
+
+	if(arg_stream->i && arg_sortorder->i)
+	{
+		print_error("'--stream' prints files unsorted, it can't be combined with '-o'");
+		goto clean_up;
+	}
+
+	if((arg_top->i || arg_bottom->i) && (arg_stream->i || (arg_top->i && arg_bottom->i)))
+	{
+		print_error("'--top' and '--bottom' sort by line count, they can't be combined with '--stream' or each other");
+		goto clean_up;
+	}
+
+	/* the format is glued to the option, "--format=csv" */
+	jctl_emit_format format = JCTL_EMIT_TEXT;
+	if(arg_format->i)
+	{
+		format = ofp_option_enumval(arg_format, 4,
+			"=text", 5, JCTL_EMIT_TEXT,
+			"=jsonl", 6, JCTL_EMIT_JSONL,
+			"=csv", 4, JCTL_EMIT_CSV,
+			"=bin", 4, JCTL_EMIT_BIN
+		);
+
+		if(format == -1)
+		{
+			vprintf_error("undefined format '%s' for argument '-%s'", arg_format->v.o + (arg_format->v.o[0] == '='), arg_format->id);
+			goto clean_up;
+		}
+	}
+
+	if(arg_filesfrom->i && arg_files0from->i)
+	{
+		print_error("'--files-from' and '--files0-from' can't be combined");
+		goto clean_up;
+	}
+
+	if(arg_snapshot->i && (arg_stream->i || arg_top->i || arg_bottom->i || arg_bydir->i || arg_byext->i))
+	{
+		print_error("'--save-snapshot' saves every file, it can't be combined with '--stream', '--top', '--bottom', '--by-dir' or '--by-ext'");
+		goto clean_up;
+	}
+
+	if(format != JCTL_EMIT_TEXT && (arg_bydir->i || arg_byext->i))
+	{
+		print_error("'--format' writes a record per file, it can't be combined with '--by-dir' or '--by-ext'");
+		goto clean_up;
+	}
+
+	jctl_graph_config cfg;
+	cfg.so = so;
+	cfg.format = format;
+	cfg.snapshot = arg_snapshot->i ? arg_snapshot->v.o : NULL;
+	cfg.bufsize = JCTL_FILE_BUFSIZE_DEFAULT;
+
+	if(arg_bufsize->i)
+	{
+		unsigned long kib;
+		if(option_uint(arg_bufsize, JCTL_FILE_BUFSIZE_MIN / 1024, JCTL_FILE_BUFSIZE_MAX / 1024, &kib))
+			goto clean_up;
+		cfg.bufsize = kib * 1024;
+	}
+
+	cfg.jobs = jctl_pool_cpucount();
+	cfg.uring = arg_uring->i;
+	cfg.cache = arg_cache->i;
+	cfg.recursive = arg_recursive->i;
+	cfg.ignore = !arg_noignore->i;
+	cfg.stream = arg_stream->i;
+	cfg.top = 0;
+	cfg.keep = so;
+
+	if(arg_jobs->i)
+	{
+		unsigned long jobs;
+		if(option_uint(arg_jobs, 1, JCTL_POOL_MAX_WORKERS, &jobs))
+			goto clean_up;
+		cfg.jobs = jobs;
+	}
+
+	if(arg_top->i || arg_bottom->i)
+	{
+		unsigned long top;
+		if(option_uint(arg_top->i ? arg_top : arg_bottom, 1, JCTL_GRAPH_TOP_MAX, &top))
+			goto clean_up;
+		cfg.top = top;
+		cfg.keep = arg_top->i ? JCTL_GRAPH_SORT_LINE_DEC : JCTL_GRAPH_SORT_LINE_INC;
+
+		/* '-o' only orders the files kept */
+		if(!arg_sortorder->i)
+			cfg.so = cfg.keep;
+	}
+
+	/* the depth is glued to the option, "--by-dir=2" */
+	cfg.bydir = arg_bydir->i;
+	cfg.dirdepth = 0;
+	cfg.byext = arg_byext->i;
+	if(arg_bydir->i && arg_bydir->v.o[0] != '\0')
+	{
+		unsigned long depth;
+		if(arg_bydir->v.o[0] != '=')
+		{
+			vprintf_error("unrecognized value '%s' for argument '-%s', expected '=depth'", arg_bydir->v.o, arg_bydir->id);
+			goto clean_up;
+		}
+		++arg_bydir->v.o;
+		if(option_uint(arg_bydir, 1, JCTL_GRAPH_DIR_DEPTH_MAX, &depth))
+			goto clean_up;
+		cfg.dirdepth = depth;
+	}
+
+	cfg.filter = NULL;
+
+	if(arg_include->i || arg_exclude->i)
+	{
+		const char *bad;
+		filtered = 1;
+		if(jctl_filter_init(&filter, arg_include->i ? arg_include->v.o : NULL, arg_exclude->i ? arg_exclude->v.o : NULL, &bad))
+		{
+			if(bad != NULL)
+				vprintf_error("invalid wildcard '%s'", bad);
+			else
+				print_error("out of memory");
+			goto clean_up;
+		}
+		cfg.filter = &filter;
+	}
+
+	cfg.list = NULL;
+
+	if(arg_filesfrom->i || arg_files0from->i)
+	{
+		ofp_argument *arg = arg_filesfrom->i ? arg_filesfrom : arg_files0from;
+		listfn = arg->v.o;
+		if(jctl_list_open(&list, listfn, arg_filesfrom->i ? '\n' : '\0'))
+		{
+			vprintf_error("can't read file list '%s'", listfn);
+			goto clean_up;
+		}
+		listed = 1;
+		cfg.list = &list;
+	}
+
+	jctl_uint err = jctl_graph_run(S, &cfg);
+	if(err & JCTL_GRAPH_ERR_SNAPSHOT)
+	{
+		vprintf_error("can't write snapshot '%s'", cfg.snapshot);
+	}
+	if(err & JCTL_GRAPH_ERR_MEMORY)
+	{
+		_jctl_printf("jctl: error: out of memory\n");
+	}
+
+	/* the names read before it failed are counted */
+	if(listed && list.err)
+	{
+		vprintf_error("can't read file list '%s'", listfn);
+	}
+
+	/*
+	*
+	* JCTL Clean-Up
+	*
+	*/
+
+clean_up:
+	if(filtered)
+		jctl_filter_free(&filter);
+	if(listed)
+		jctl_list_free(&list);
+	ofp_state_free(S);
+
+	return EXIT_SUCCESS;
 }
\ No newline at end of file
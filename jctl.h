@@ -1,19 +1,21 @@
-#ifndef JCTL_H
-#define JCTL_H
-
-#include <stdlib.h>
-#include <stdio.h>
-#include <string.h>
-
-
-#define _jctl_graph_sort qsort
-
-#define _jctl_strlen strlen
-#define _jctl_printf printf
-#define _jctl_strcmp strcmp
-#define _jctl_strspn strspn
-
-typedef unsigned int jctl_uint;
-
-
+#ifndef JCTL_H
+#define JCTL_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+
+#define _jctl_graph_sort qsort
+
+#define _jctl_strlen strlen
+#define _jctl_printf printf
+#define _jctl_strcmp strcmp
+#define _jctl_strspn strspn
+#define _jctl_strpbrk strpbrk
+
+typedef unsigned int jctl_uint;
+typedef unsigned long long jctl_size;
+
+
 #endif /* JCTL_H */
\ No newline at end of file
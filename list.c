@@ -0,0 +1,148 @@
+#include "list.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+
+#ifdef _WIN32
+	#include <io.h>
+#else
+	#include <unistd.h>
+#endif
+
+#ifndef O_BINARY
+	#define O_BINARY (0)
+#endif
+
+
+/*
+ * Open file list 'fn' as list 'l', standard input if 'fn' is "-".
+ * Names are separated by 'sep', '\0' for lists of 'find -print0'
+ * or '\n' for one name per line (a CR before it is dropped too).
+ * Return 0 on success, otherwise (the list can't be opened) return 1.
+ */
+jctl_uint jctl_list_open (jctl_list *l, const char *fn, char sep)
+{
+	l->fd = (strcmp(fn, "-") == 0) ? 0 : open(fn, O_RDONLY | O_BINARY);
+	l->sep = sep;
+	l->err = 0;
+	l->buf = NULL;
+	l->cap = 0;
+	l->size = 0;
+	l->end = 0;
+	l->pos = 0;
+	return (l->fd < 0);
+}
+
+
+/*
+ * Close list 'l' once read to the end.
+ */
+static void jctl_list_close (jctl_list *l)
+{
+	if(l->fd > 0)
+		close(l->fd);
+	l->fd = -1;
+}
+
+
+/*
+ * Close list 'l' and free its names.
+ */
+void jctl_list_free (jctl_list *l)
+{
+	jctl_list_close(l);
+	free(l->buf);
+	l->buf = NULL;
+	l->cap = 0;
+	l->size = 0;
+	l->end = 0;
+	l->pos = 0;
+}
+
+
+/*
+ * Read the next part of list 'l', at least one complete name
+ * unless the list ends, handed out by 'jctl_list_next'.
+ * The incomplete name at the end of the part before is moved
+ * to the front of the buffer and completed, the buffer only grows
+ * for a name that doesn't fit. The last name needs no separator.
+ * Return 0 if a part got read, otherwise (the list ended, or can't be
+ * read any further or out of memory, then 'l->err' is set) return 1.
+ */
+jctl_uint jctl_list_read (jctl_list *l)
+{
+	if(l->fd < 0)
+		return 1;
+
+	size_t rest = l->size - l->pos;
+	if(rest > 0)
+		memmove(l->buf, l->buf + l->pos, rest);
+	l->size = rest;
+	l->end = 0;
+	l->pos = 0;
+
+	while(l->end == 0)
+	{
+		/* one byte more than read, for terminating the last name */
+		if(l->cap - l->size < 2)
+		{
+			size_t ncap = (l->cap == 0) ? JCTL_LIST_BUFSIZE : l->cap * 2;
+			char *buf = (char*)realloc(l->buf, ncap);
+			if(buf == NULL)
+			{
+				l->err = 1;
+				jctl_list_close(l);
+				return 1;
+			}
+			l->buf = buf;
+			l->cap = ncap;
+		}
+
+		size_t want = l->cap - l->size - 1;
+		long long n = read(l->fd, l->buf + l->size, (unsigned int)(want > (1 << 30) ? (1 << 30) : want));
+		if(n < 0 && errno == EINTR)
+			continue;
+		if(n < 0)
+			l->err = 1;
+		if(n <= 0)
+		{
+			jctl_list_close(l);
+			l->buf[l->size] = '\0';
+			l->end = l->size;
+			break;
+		}
+
+		char *p = l->buf + l->size;
+		char *end = p + n;
+		l->size += (size_t) n;
+		for(; (p = (char*)memchr(p, l->sep, end - p)) != NULL; ++p)
+		{
+			*p = '\0';
+			if(l->sep != '\0' && p > l->buf && p[-1] == '\r')
+				p[-1] = '\0';
+			l->end = (size_t)(p - l->buf) + 1;
+		}
+	}
+
+	return (l->end == 0);
+}
+
+
+/*
+ * Return the next complete name of the part of list 'l' read last
+ * and its length in 'len', or NULL if there are no more.
+ * Empty names are skipped.
+ */
+char *jctl_list_next (jctl_list *l, size_t *len)
+{
+	while(l->pos < l->end && l->buf[l->pos] == '\0')
+		++l->pos;
+	if(l->pos >= l->end)
+		return NULL;
+
+	char *name = l->buf + l->pos;
+	*len = strlen(name);
+	l->pos += *len + 1;
+	return name;
+}
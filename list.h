@@ -0,0 +1,44 @@
+#ifndef JCTL_LIST_H
+#define JCTL_LIST_H
+
+#include "jctl.h"
+#include <stddef.h>
+
+
+/*
+ * Size of the buffer a file list is read into part by part,
+ * doubled only for a name that doesn't fit.
+ */
+#define JCTL_LIST_BUFSIZE	(1024 * 1024)
+
+
+/*
+*
+* File List
+*
+* Names of files to count, read by '--files-from' and '--files0-from'
+* one buffer at a time while the names of the part before get counted.
+* The complete names of a part are split up in place,
+* an incomplete one at its end is carried over to the next part.
+*
+*/
+typedef struct jctl_list_s
+{
+	int fd;			/* list file, -1 once read to the end */
+	char sep;		/* name separator */
+	jctl_uint err;	/* the list couldn't be read to the end */
+	char *buf;		/* part read, the complete names terminated */
+	size_t cap;		/* buffer size */
+	size_t size;	/* bytes read */
+	size_t end;		/* end of the complete names */
+	size_t pos;		/* offset of the next name */
+} jctl_list;
+
+
+jctl_uint	jctl_list_open	(jctl_list *l, const char *fn, char sep);
+void		jctl_list_free	(jctl_list *l);
+jctl_uint	jctl_list_read	(jctl_list *l);
+char*		jctl_list_next	(jctl_list *l, size_t *len);
+
+
+#endif /* JCTL_LIST_H */
@@ -0,0 +1,184 @@
+#include "out.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#ifdef _WIN32
+	#include <io.h>
+#else
+	#include <unistd.h>
+#endif
+
+
+/*
+ * Initialize writer 'o' for file descriptor 'fd'
+ * with a buffer of 'cap' bytes.
+ * Return 0 on success, otherwise (out of memory) return 1.
+ */
+jctl_uint jctl_out_init (jctl_out *o, int fd, size_t cap)
+{
+	o->fd = fd;
+	o->top = 0;
+	o->cap = cap;
+	o->err = 0;
+	o->lock = NULL;
+	o->buf = (char*)malloc(cap);
+	return (o->buf == NULL);
+}
+
+
+/*
+ * Free the buffer of writer 'o',
+ * without writing what is left in it.
+ */
+void jctl_out_free (jctl_out *o)
+{
+	free(o->buf);
+	o->buf = NULL;
+	o->top = 0;
+}
+
+
+/*
+ * Write the buffer of writer 'o' and empty it.
+ * Return 0 on success, otherwise return 1,
+ * everything written after a failed write gets dropped.
+ */
+jctl_uint jctl_out_flush (jctl_out *o)
+{
+	const char *p = o->buf;
+	size_t size = o->top;
+	o->top = 0;
+
+	if(size == 0 || o->err)
+		return o->err;
+
+	if(o->lock != NULL)
+		pthread_mutex_lock(o->lock);
+
+	while(size > 0)
+	{
+		long long n = write(o->fd, p, (unsigned int)(size > (1 << 30) ? (1 << 30) : size));
+		if(n < 0 && errno == EINTR)
+			continue;
+		if(n <= 0)
+		{
+			o->err = 1;
+			break;
+		}
+		p += n;
+		size -= (size_t) n;
+	}
+
+	if(o->lock != NULL)
+		pthread_mutex_unlock(o->lock);
+
+	return o->err;
+}
+
+
+/*
+ * Make room for 'n' more bytes in the buffer of writer 'o',
+ * writing it first if they don't fit.
+ * The buffer grows if they don't fit an empty one either,
+ * so a line reserved at once is always written at once.
+ * Return 0 on success, otherwise (out of memory) return 1.
+ */
+jctl_uint jctl_out_reserve (jctl_out *o, size_t n)
+{
+	if(o->cap - o->top >= n)
+		return 0;
+
+	jctl_out_flush(o);
+	if(o->cap >= n)
+		return 0;
+
+	char *buf = (char*)realloc(o->buf, n);
+	if(buf == NULL)
+		return 1;
+	o->buf = buf;
+	o->cap = n;
+	return 0;
+}
+
+
+/*
+ * Add the 'n' bytes of 's' to the output of writer 'o'.
+ */
+void jctl_out_write (jctl_out *o, const char *s, size_t n)
+{
+	while(n > 0)
+	{
+		if(o->top == o->cap)
+			jctl_out_flush(o);
+
+		size_t run = (o->cap - o->top < n) ? o->cap - o->top : n;
+		memcpy(o->buf + o->top, s, run);
+		o->top += run;
+		s += run;
+		n -= run;
+	}
+}
+
+
+/*
+ * Add 'n' times character 'c' to the output of writer 'o',
+ * used for paddings and graph bars.
+ */
+void jctl_out_fill (jctl_out *o, char c, size_t n)
+{
+	while(n > 0)
+	{
+		if(o->top == o->cap)
+			jctl_out_flush(o);
+
+		size_t run = (o->cap - o->top < n) ? o->cap - o->top : n;
+		memset(o->buf + o->top, c, run);
+		o->top += run;
+		n -= run;
+	}
+}
+
+
+/*
+ * Add unsigned integer 'n' in decimal to the output of writer 'o'.
+ * The digits are written backwards into a small buffer,
+ * two at a time from a table of all pairs.
+ */
+void jctl_out_uint (jctl_out *o, jctl_size n)
+{
+	static const char pairs[] =
+		"00010203040506070809"
+		"10111213141516171819"
+		"20212223242526272829"
+		"30313233343536373839"
+		"40414243444546474849"
+		"50515253545556575859"
+		"60616263646566676869"
+		"70717273747576777879"
+		"80818283848586878889"
+		"90919293949596979899";
+
+	char digits[20];
+	char *p = digits + sizeof(digits);
+
+	while(n >= 100)
+	{
+		jctl_uint k = (jctl_uint)(n % 100) * 2;
+		n /= 100;
+		*--p = pairs[k + 1];
+		*--p = pairs[k];
+	}
+
+	if(n >= 10)
+	{
+		*--p = pairs[n * 2 + 1];
+		*--p = pairs[n * 2];
+	}
+	else
+	{
+		*--p = (char)('0' + n);
+	}
+
+	jctl_out_write(o, p, digits + sizeof(digits) - p);
+}
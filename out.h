@@ -0,0 +1,49 @@
+#ifndef JCTL_OUT_H
+#define JCTL_OUT_H
+
+#include "jctl.h"
+#include <stddef.h>
+#include <pthread.h>
+
+
+/*
+ * Size of the output buffer of a listing,
+ * written out whenever it is full.
+ */
+#define JCTL_OUT_BUFSIZE	(256 * 1024)
+
+
+/*
+*
+* Output Writer
+*
+* Collects output in a buffer, written to a file descriptor
+* with a few big writes instead of a stdio call per field.
+* Numbers and paddings are formatted by hand.
+* If 'lock' is set every write holds it, so writers
+* of several threads don't mix up their output.
+*
+*/
+typedef struct jctl_out_s
+{
+	int fd;					/* file descriptor written to */
+	char *buf;				/* buffer */
+	size_t top;				/* buffered bytes */
+	size_t cap;				/* buffer capacity */
+	jctl_uint err;			/* a write failed or a record didn't fit, the output gets dropped */
+	pthread_mutex_t *lock;	/* lock held while writing, NULL if none */
+} jctl_out;
+
+
+jctl_uint	jctl_out_init		(jctl_out *o, int fd, size_t cap);
+void		jctl_out_free		(jctl_out *o);
+
+jctl_uint	jctl_out_flush		(jctl_out *o);
+jctl_uint	jctl_out_reserve	(jctl_out *o, size_t n);
+
+void		jctl_out_write		(jctl_out *o, const char *s, size_t n);
+void		jctl_out_fill		(jctl_out *o, char c, size_t n);
+void		jctl_out_uint		(jctl_out *o, jctl_size n);
+
+
+#endif /* JCTL_OUT_H */
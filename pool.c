@@ -0,0 +1,439 @@
+#ifdef __linux__
+	#define _GNU_SOURCE
+	#include <sched.h>
+#endif
+
+#include "pool.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <unistd.h>
+#endif
+
+/*
+ * Initial capacity of a worker's deque,
+ * has to be a power of two.
+ */
+#define JCTL_POOL_DEQUE_MIN (64)
+
+
+#ifdef __linux__
+/*
+ * Return the CPU limit set by the cgroup CPU quota
+ * in file 'fn' (cgroup v2 "cpu.max" format: "quota period"),
+ * or 0 if there is no limit.
+ */
+static jctl_uint jctl_pool_cgroup_v2 (const char *fn)
+{
+	FILE *fp = fopen(fn, "r");
+	if(fp == NULL)
+		return 0;
+
+	char quota[32];
+	unsigned long period;
+	jctl_uint n = 0;
+
+	if(fscanf(fp, "%31s %lu", quota, &period) == 2 && strcmp(quota, "max") != 0 && period > 0)
+		n = (jctl_uint)((strtoul(quota, NULL, 10) + period - 1) / period);
+
+	fclose(fp);
+	return n;
+}
+
+
+/*
+ * Return the CPU limit set by the cgroup v1
+ * CFS quota and period files, or 0 if there is no limit.
+ */
+static jctl_uint jctl_pool_cgroup_v1 (const char *quotafn, const char *periodfn)
+{
+	FILE *fq = fopen(quotafn, "r");
+	FILE *fp = fopen(periodfn, "r");
+	long quota = -1;
+	long period = 0;
+
+	if(fq != NULL)
+	{
+		if(fscanf(fq, "%ld", &quota) != 1)
+			quota = -1;
+		fclose(fq);
+	}
+	if(fp != NULL)
+	{
+		if(fscanf(fp, "%ld", &period) != 1)
+			period = 0;
+		fclose(fp);
+	}
+
+	if(quota <= 0 || period <= 0)
+		return 0;
+	return (jctl_uint)((quota + period - 1) / period);
+}
+
+
+/*
+ * Return the CPU limit of the cgroup this process runs in,
+ * or 0 if there is no limit.
+ */
+static jctl_uint jctl_pool_cgroup (void)
+{
+	char path[4096] = "";
+	char fn[4096 + 64];
+
+	/*
+	 * Find the cgroup v2 path of this process,
+	 * the line "0::/path" in /proc/self/cgroup.
+	 */
+	FILE *fp = fopen("/proc/self/cgroup", "r");
+	if(fp != NULL)
+	{
+		char line[sizeof(path)];
+		while(fgets(line, sizeof(line), fp) != NULL)
+		{
+			if(strncmp(line, "0::", 3) == 0)
+			{
+				line[strcspn(line, "\n")] = '\0';
+				strcpy(path, line + 3);
+				break;
+			}
+		}
+		fclose(fp);
+	}
+
+	jctl_uint n = 0;
+	if(path[0] != '\0' && strcmp(path, "/") != 0)
+	{
+		snprintf(fn, sizeof(fn), "/sys/fs/cgroup%s/cpu.max", path);
+		n = jctl_pool_cgroup_v2(fn);
+	}
+	if(n == 0)
+		n = jctl_pool_cgroup_v2("/sys/fs/cgroup/cpu.max");
+	if(n == 0)
+		n = jctl_pool_cgroup_v1("/sys/fs/cgroup/cpu/cpu.cfs_quota_us", "/sys/fs/cgroup/cpu/cpu.cfs_period_us");
+	if(n == 0)
+		n = jctl_pool_cgroup_v1("/sys/fs/cgroup/cpu,cpuacct/cpu.cfs_quota_us", "/sys/fs/cgroup/cpu,cpuacct/cpu.cfs_period_us");
+
+	return n;
+}
+#endif /* defined(__linux__) */
+
+
+/*
+ * Return the amount of CPUs this process may run on.
+ * Takes the CPU affinity mask and cgroup CPU quota into account.
+ */
+jctl_uint jctl_pool_cpucount (void)
+{
+	long n;
+
+#ifdef _WIN32
+	SYSTEM_INFO si;
+	GetSystemInfo(&si);
+	n = si.dwNumberOfProcessors;
+#else
+	n = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+
+#ifdef __linux__
+	cpu_set_t set;
+	if(sched_getaffinity(0, sizeof(set), &set) == 0)
+	{
+		long a = CPU_COUNT(&set);
+		if(a > 0 && a < n)
+			n = a;
+	}
+
+	long q = jctl_pool_cgroup();
+	if(q > 0 && q < n)
+		n = q;
+#endif /* defined(__linux__) */
+
+	if(n < 1)
+		n = 1;
+	if(n > JCTL_POOL_MAX_WORKERS)
+		n = JCTL_POOL_MAX_WORKERS;
+
+	return (jctl_uint) n;
+}
+
+
+/*
+ * Create a new pool of 'n' workers.
+ * The worker threads are started by 'jctl_pool_run'.
+ * Return the pool, or NULL if out of memory.
+ */
+jctl_pool *jctl_pool_new (jctl_uint n)
+{
+	if(n < 1)
+		n = 1;
+
+	jctl_pool *p = (jctl_pool*)malloc(sizeof(*p));
+	if(p == NULL)
+		return NULL;
+
+	p->workers = (jctl_pool_worker*)calloc(n, sizeof(*p->workers));
+	if(p->workers == NULL)
+	{
+		free(p);
+		return NULL;
+	}
+
+	p->n = n;
+	p->next = 0;
+	atomic_init(&p->pending, 0);
+	atomic_init(&p->version, 0);
+	atomic_init(&p->sleepers, 0);
+	atomic_init(&p->err, 0);
+	pthread_mutex_init(&p->idlelock, NULL);
+	pthread_cond_init(&p->idlecond, NULL);
+
+	for(jctl_uint i = 0; i < n; ++i)
+	{
+		jctl_pool_worker *w = p->workers + i;
+		w->pool = p;
+		w->id = i;
+		w->ud = NULL;
+		pthread_mutex_init(&w->lock, NULL);
+	}
+
+	return p;
+}
+
+
+/*
+ * Free pool 'p'.
+ */
+void jctl_pool_free (jctl_pool *p)
+{
+	for(jctl_uint i = 0; i < p->n; ++i)
+	{
+		jctl_pool_worker *w = p->workers + i;
+		pthread_mutex_destroy(&w->lock);
+		free(w->tasks);
+	}
+	pthread_mutex_destroy(&p->idlelock);
+	pthread_cond_destroy(&p->idlecond);
+	free(p->workers);
+	free(p);
+}
+
+
+/*
+ * Push task 't' to the tail of the deque of worker 'w'.
+ * Return 0 on success, otherwise (out of memory) return 1.
+ */
+static int jctl_pool_push (jctl_pool_worker *w, jctl_pool_task *t)
+{
+	int err = 0;
+	pthread_mutex_lock(&w->lock);
+
+	if(w->tail - w->head == w->cap)
+	{
+		/*
+		 * Grow the deque, the head and tail are
+		 * free running so every task has to be
+		 * put into its slot of the new capacity.
+		 */
+		size_t cap = w->cap ? w->cap * 2 : JCTL_POOL_DEQUE_MIN;
+		jctl_pool_task *tasks = (jctl_pool_task*)malloc(sizeof(*tasks) * cap);
+		if(tasks == NULL)
+			err = 1;
+		else
+		{
+			for(size_t i = w->head; i != w->tail; ++i)
+				tasks[i & (cap - 1)] = w->tasks[i & (w->cap - 1)];
+			free(w->tasks);
+			w->tasks = tasks;
+			w->cap = cap;
+		}
+	}
+
+	if(!err)
+	{
+		w->tasks[w->tail & (w->cap - 1)] = *t;
+		++w->tail;
+	}
+
+	pthread_mutex_unlock(&w->lock);
+	return err;
+}
+
+
+/*
+ * Pop the newest task of worker 'w' into 't'.
+ * Return 1 if there was one, otherwise return 0.
+ */
+static int jctl_pool_pop (jctl_pool_worker *w, jctl_pool_task *t)
+{
+	int found = 0;
+	pthread_mutex_lock(&w->lock);
+	if(w->tail != w->head)
+	{
+		--w->tail;
+		*t = w->tasks[w->tail & (w->cap - 1)];
+		found = 1;
+	}
+	pthread_mutex_unlock(&w->lock);
+	return found;
+}
+
+
+/*
+ * Steal the oldest task of worker 'w' into 't'.
+ * Return 1 if there was one, otherwise return 0.
+ */
+static int jctl_pool_steal (jctl_pool_worker *w, jctl_pool_task *t)
+{
+	int found = 0;
+	pthread_mutex_lock(&w->lock);
+	if(w->tail != w->head)
+	{
+		*t = w->tasks[w->head & (w->cap - 1)];
+		++w->head;
+		found = 1;
+	}
+	pthread_mutex_unlock(&w->lock);
+	return found;
+}
+
+
+/*
+ * Find a task for worker 'w', first in its own deque
+ * and then in the deques of the other workers.
+ * Return 1 if one was found, otherwise return 0.
+ */
+static int jctl_pool_find (jctl_pool_worker *w, jctl_pool_task *t)
+{
+	jctl_pool *p = w->pool;
+
+	if(jctl_pool_pop(w, t))
+		return 1;
+
+	for(jctl_uint k = 1; k < p->n; ++k)
+		if(jctl_pool_steal(p->workers + (w->id + k) % p->n, t))
+			return 1;
+
+	return 0;
+}
+
+
+/*
+ * Submit a new task calling 'fn' with 'arg' and 'i'.
+ * Tasks submitted by worker 'w' go to its own deque,
+ * tasks submitted from outside the pool ('w' is NULL)
+ * are spread over all the workers.
+ */
+void jctl_pool_submit (jctl_pool *p, jctl_pool_worker *w, jctl_pool_fn fn, void *arg, size_t i)
+{
+	jctl_pool_task t;
+	t.fn = fn;
+	t.arg = arg;
+	t.i = i;
+
+	if(w == NULL)
+	{
+		w = p->workers + p->next;
+		p->next = (p->next + 1) % p->n;
+	}
+
+	atomic_fetch_add(&p->pending, 1);
+	if(jctl_pool_push(w, &t))
+	{
+		atomic_store(&p->err, 1);
+		atomic_fetch_sub(&p->pending, 1);
+		return;
+	}
+
+	/*
+	 * Wake up a sleeping worker.
+	 * Sleepers register themselves before checking the version,
+	 * so either they see the new version or we see them.
+	 */
+	atomic_fetch_add(&p->version, 1);
+	if(atomic_load(&p->sleepers) > 0)
+	{
+		pthread_mutex_lock(&p->idlelock);
+		pthread_cond_signal(&p->idlecond);
+		pthread_mutex_unlock(&p->idlelock);
+	}
+}
+
+
+/*
+ * Main loop of worker 'ud'.
+ * Runs tasks until every submitted task has finished.
+ */
+static void *jctl_pool_main (void *ud)
+{
+	jctl_pool_worker *w = (jctl_pool_worker*) ud;
+	jctl_pool *p = w->pool;
+
+	for(;;)
+	{
+		size_t version = atomic_load(&p->version);
+
+		jctl_pool_task t;
+		if(jctl_pool_find(w, &t))
+		{
+			t.fn(w, t.arg, t.i);
+
+			if(atomic_fetch_sub(&p->pending, 1) == 1)
+			{
+				/* last task, wake everyone up to quit */
+				pthread_mutex_lock(&p->idlelock);
+				pthread_cond_broadcast(&p->idlecond);
+				pthread_mutex_unlock(&p->idlelock);
+			}
+			continue;
+		}
+
+		pthread_mutex_lock(&p->idlelock);
+		atomic_fetch_add(&p->sleepers, 1);
+		while(atomic_load(&p->version) == version && atomic_load(&p->pending) != 0)
+			pthread_cond_wait(&p->idlecond, &p->idlelock);
+		atomic_fetch_sub(&p->sleepers, 1);
+		int done = (atomic_load(&p->pending) == 0);
+		pthread_mutex_unlock(&p->idlelock);
+
+		if(done)
+			break;
+	}
+
+	return NULL;
+}
+
+
+/*
+ * Run pool 'p' until all its tasks, including
+ * the ones submitted while running, have finished.
+ * The calling thread works as the first worker.
+ *
+ * Return 0 if every task got run,
+ * otherwise (a task couldn't be submitted) return 1.
+ */
+jctl_uint jctl_pool_run (jctl_pool *p)
+{
+	int *started = (int*)calloc(p->n, sizeof(*started));
+
+	/*
+	 * Workers that fail to start are no problem,
+	 * their tasks get stolen by the others.
+	 */
+	for(jctl_uint i = 1; i < p->n && started != NULL; ++i)
+	{
+		jctl_pool_worker *w = p->workers + i;
+		started[i] = (pthread_create(&w->thread, NULL, jctl_pool_main, w) == 0);
+	}
+
+	jctl_pool_main(p->workers);
+
+	for(jctl_uint i = 1; i < p->n && started != NULL; ++i)
+		if(started[i])
+			pthread_join(p->workers[i].thread, NULL);
+
+	free(started);
+	return atomic_load(&p->err);
+}
@@ -0,0 +1,89 @@
+#ifndef JCTL_POOL_H
+#define JCTL_POOL_H
+
+#include "jctl.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+
+/*
+ * Maximum amount of pool workers.
+ */
+#define JCTL_POOL_MAX_WORKERS	(1024)
+
+
+typedef struct jctl_pool_s			jctl_pool;
+typedef struct jctl_pool_worker_s	jctl_pool_worker;
+
+/*
+ * Task function, called by worker 'w'
+ * with the argument 'arg' and index 'i' the task was submitted with.
+ */
+typedef void (*jctl_pool_fn) (jctl_pool_worker *w, void *arg, size_t i);
+
+
+/*
+*
+* Pool Task
+*
+*/
+typedef struct jctl_pool_task_s
+{
+	jctl_pool_fn fn;	/* task function */
+	void *arg;			/* argument */
+	size_t i;			/* index */
+} jctl_pool_task;
+
+
+/*
+*
+* Pool Worker
+*
+* Every worker owns a deque of tasks.
+* The owner pushes and pops tasks at the tail,
+* idle workers steal them from the head.
+*
+*/
+struct jctl_pool_worker_s
+{
+	jctl_pool *pool;			/* owning pool */
+	jctl_uint id;				/* worker index */
+	void *ud;					/* user data */
+	pthread_t thread;			/* worker thread */
+	pthread_mutex_t lock;		/* deque lock */
+	jctl_pool_task *tasks;		/* deque */
+	size_t head;				/* deque head */
+	size_t tail;				/* deque tail */
+	size_t cap;					/* deque capacity */
+};
+
+
+/*
+*
+* Pool
+*
+*/
+struct jctl_pool_s
+{
+	jctl_uint n;				/* worker count */
+	jctl_uint next;				/* next worker for tasks submitted from outside */
+	jctl_pool_worker *workers;	/* workers */
+	atomic_size_t pending;		/* tasks submitted but not finished */
+	atomic_size_t version;		/* bumped on every submit */
+	atomic_uint sleepers;		/* workers waiting for tasks */
+	pthread_mutex_t idlelock;	/* idle lock */
+	pthread_cond_t idlecond;	/* idle condition */
+	atomic_int err;				/* a submit ran out of memory */
+};
+
+
+jctl_uint	jctl_pool_cpucount	(void);
+
+jctl_pool*	jctl_pool_new		(jctl_uint n);
+void		jctl_pool_free		(jctl_pool *p);
+
+void		jctl_pool_submit	(jctl_pool *p, jctl_pool_worker *w, jctl_pool_fn fn, void *arg, size_t i);
+jctl_uint	jctl_pool_run		(jctl_pool *p);
+
+
+#endif /* JCTL_POOL_H */
@@ -0,0 +1,265 @@
+#include "rollup.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+/*
+ * Return the hash of key 'key' of length 'len'.
+ */
+static size_t jctl_rollup_hash (const char *key, size_t len)
+{
+	size_t h = 2166136261u;
+	for(size_t i = 0; i < len; ++i)
+		h = (h ^ (unsigned char) key[i]) * 16777619u;
+	return h;
+}
+
+
+/*
+ * Return the index of the slot of key 'key' of length 'len'
+ * and hash 'hash' in slots 'slots' of 'cap',
+ * or of the empty slot it would go into.
+ */
+static size_t jctl_rollup_probe (jctl_rollup_slot *slots, size_t cap, const char *key, size_t len, size_t hash)
+{
+	size_t mask = cap - 1;
+	size_t i = hash & mask;
+
+	for(;; i = (i + 1) & mask)
+	{
+		jctl_rollup_slot *s = slots + i;
+		if(s->key == NULL || (s->hash == hash && s->len == len && memcmp(s->key, key, len) == 0))
+			return i;
+	}
+}
+
+
+/*
+ * Initialize empty roll-up 'r'.
+ * Memory is only allocated by the first key.
+ */
+void jctl_rollup_init (jctl_rollup *r)
+{
+	r->slots = NULL;
+	r->cap = 0;
+	r->count = 0;
+	r->last = 0;
+	jctl_arena_init(&r->keys);
+}
+
+
+/*
+ * Free the slots and keys of roll-up 'r'.
+ */
+void jctl_rollup_free (jctl_rollup *r)
+{
+	free(r->slots);
+	jctl_arena_free(&r->keys);
+	jctl_rollup_init(r);
+}
+
+
+/*
+ * Double the capacity of roll-up 'r', or allocate the first slots.
+ * Return 0 on success, otherwise (out of memory) return 1.
+ */
+static int jctl_rollup_grow (jctl_rollup *r)
+{
+	size_t cap = (r->cap == 0) ? JCTL_ROLLUP_MIN : r->cap * 2;
+	jctl_rollup_slot *slots = (jctl_rollup_slot*)calloc(cap, sizeof(*slots));
+	if(slots == NULL)
+		return 1;
+
+	for(size_t i = 0; i < r->cap; ++i)
+	{
+		jctl_rollup_slot *s = r->slots + i;
+		if(s->key != NULL)
+			slots[jctl_rollup_probe(slots, cap, s->key, s->len, s->hash)] = *s;
+	}
+
+	free(r->slots);
+	r->slots = slots;
+	r->cap = cap;
+	r->last = 0;
+	return 0;
+}
+
+
+/*
+ * Add 'lines' under key 'key' of length 'len' of roll-up 'r',
+ * 'copy' tells if the key has to be copied into its arena.
+ * Return 0 on success, otherwise (out of memory) return 1.
+ */
+static jctl_uint jctl_rollup_put (jctl_rollup *r, const char *key, size_t len, jctl_size lines, jctl_uint copy)
+{
+	if(r->cap > 0)
+	{
+		jctl_rollup_slot *s = r->slots + r->last;
+		if(s->key != NULL && s->len == len && memcmp(s->key, key, len) == 0)
+		{
+			s->lines += lines;
+			return 0;
+		}
+	}
+
+	/* at most three quarters full */
+	if((r->count + 1) * 4 > r->cap * 3 && jctl_rollup_grow(r))
+		return 1;
+
+	size_t hash = jctl_rollup_hash(key, len);
+	size_t i = jctl_rollup_probe(r->slots, r->cap, key, len, hash);
+	jctl_rollup_slot *s = r->slots + i;
+
+	if(s->key == NULL)
+	{
+		if(copy)
+		{
+			char *k = (char*)jctl_arena_alloc(&r->keys, len + 1);
+			if(k == NULL)
+				return 1;
+			memcpy(k, key, len);
+			k[len] = '\0';
+			key = k;
+		}
+		s->key = key;
+		s->len = len;
+		s->hash = hash;
+		s->lines = 0;
+		++r->count;
+	}
+
+	s->lines += lines;
+	r->last = i;
+	return 0;
+}
+
+
+/*
+ * Add 'lines' under key 'key' of length 'len' of roll-up 'r'.
+ * Return 0 on success, otherwise (out of memory) return 1.
+ */
+jctl_uint jctl_rollup_add (jctl_rollup *r, const char *key, size_t len, jctl_size lines)
+{
+	return jctl_rollup_put(r, key, len, lines, 1);
+}
+
+
+/*
+ * Add all keys of roll-up 'from' to roll-up 'r',
+ * leaving 'from' empty.
+ * The keys move over with the arena of 'from', without copying them.
+ * Return 0 on success, otherwise (out of memory) return 1.
+ */
+jctl_uint jctl_rollup_merge (jctl_rollup *r, jctl_rollup *from)
+{
+	jctl_uint err = 0;
+
+	jctl_arena_merge(&r->keys, &from->keys);
+	for(size_t i = 0; i < from->cap && !err; ++i)
+	{
+		jctl_rollup_slot *s = from->slots + i;
+		if(s->key != NULL)
+			err = jctl_rollup_put(r, s->key, s->len, s->lines, 0);
+	}
+
+	free(from->slots);
+	jctl_rollup_init(from);
+	return err;
+}
+
+
+/*
+ * Return the directory of path 'fp' of directory length 'dirlen'
+ * as key of a roll-up, and its length in 'len'.
+ * Files of the working directory are in ".", those of the root in "/"
+ * (which has its directory length at 0 too).
+ * A leading "./" is dropped, so "./dir/f" and "dir/f" are both in "dir".
+ * Unless 'depth' is 0, only the first 'depth' levels are kept,
+ * the root is no level of its own.
+ */
+const char *jctl_rollup_dir (const char *fp, size_t dirlen, jctl_uint depth, size_t *len)
+{
+	while(dirlen > 1 && fp[0] == '.' && fp[1] == '/')
+	{
+		fp += 2;
+		dirlen -= 2;
+	}
+
+	if(dirlen == 0)
+	{
+		*len = 1;
+		return (fp[0] == '/') ? "/" : ".";
+	}
+
+	*len = dirlen;
+	if(depth > 0)
+	{
+		for(size_t i = (fp[0] == '/'); i < dirlen; ++i)
+		{
+			if(fp[i] == '/' && --depth == 0)
+			{
+				*len = i;
+				break;
+			}
+		}
+	}
+	return fp;
+}
+
+
+/*
+ * Add the lines of every directory of roll-up 'r' to all its
+ * parent directories, so every directory sums up the ones below it.
+ * Parents without lines of their own get added.
+ * Relative directories at the top, but "..", are below ".",
+ * the root directory "/", "." and ".." have no parents.
+ * Return 0 on success, otherwise (out of memory) return 1.
+ */
+jctl_uint jctl_rollup_parents (jctl_rollup *r)
+{
+	/* the keys as they are, before parents get added */
+	size_t n = 0;
+	jctl_rollup_slot *own = (jctl_rollup_slot*)malloc(sizeof(*own) * (r->count + 1));
+	if(own == NULL)
+		return 1;
+	for(size_t i = 0; i < r->cap; ++i)
+		if(r->slots[i].key != NULL)
+			own[n++] = r->slots[i];
+
+	jctl_uint err = 0;
+	for(size_t i = 0; i < n && !err; ++i)
+	{
+		const char *key = own[i].key;
+		size_t len = own[i].len;
+		if(len == 1 && (key[0] == '/' || key[0] == '.'))
+			continue;
+
+		while(!err)
+		{
+			size_t top = len;
+			while(len > 0 && key[len - 1] != '/')
+				--len;
+
+			/* 'top' is the first level of a relative directory */
+			if(len == 0)
+			{
+				if(!(key[0] == '.' && (top == 1 || (top == 2 && key[1] == '.'))))
+					err = jctl_rollup_put(r, ".", 1, own[i].lines, 1);
+				break;
+			}
+
+			/* "/" stays as the parent of "/dir" */
+			if(len == 1)
+			{
+				err = jctl_rollup_put(r, key, 1, own[i].lines, 1);
+				break;
+			}
+
+			--len;
+			err = jctl_rollup_put(r, key, len, own[i].lines, 1);
+		}
+	}
+
+	free(own);
+	return err;
+}
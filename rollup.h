@@ -0,0 +1,64 @@
+#ifndef JCTL_ROLLUP_H
+#define JCTL_ROLLUP_H
+
+#include "jctl.h"
+#include "arena.h"
+#include <stddef.h>
+
+
+/*
+ * Initial capacity of a roll-up,
+ * has to be a power of two.
+ */
+#define JCTL_ROLLUP_MIN	(64)
+
+
+/*
+*
+* Roll-Up Slot
+*
+* Key and the lines summed up under it,
+* an open addressing hash table slot, empty if 'key' is NULL.
+*
+*/
+typedef struct jctl_rollup_slot_s
+{
+	const char *key;	/* key, terminated */
+	size_t len;			/* key length */
+	size_t hash;		/* key hash */
+	jctl_size lines;	/* lines summed up */
+} jctl_rollup_slot;
+
+
+/*
+*
+* Roll-Up
+*
+* Line counts summed up by a key, like a directory or an extension.
+* Keys are copied into the arena of the roll-up.
+* Files of one directory mostly come in a row,
+* so the slot of the last key is tried first.
+* Not thread safe, every thread sums up its own.
+*
+*/
+typedef struct jctl_rollup_s
+{
+	jctl_rollup_slot *slots;	/* slots */
+	size_t cap;					/* slot count, a power of two */
+	size_t count;				/* used slots */
+	size_t last;				/* slot of the last key added */
+	jctl_arena keys;			/* keys */
+} jctl_rollup;
+
+
+void		jctl_rollup_init	(jctl_rollup *r);
+void		jctl_rollup_free	(jctl_rollup *r);
+
+jctl_uint	jctl_rollup_add		(jctl_rollup *r, const char *key, size_t len, jctl_size lines);
+jctl_uint	jctl_rollup_merge	(jctl_rollup *r, jctl_rollup *from);
+jctl_uint	jctl_rollup_parents	(jctl_rollup *r);
+
+const char*	jctl_rollup_dir		(const char *fp, size_t dirlen, jctl_uint depth, size_t *len);
+
+
+#endif /* JCTL_ROLLUP_H */
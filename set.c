@@ -0,0 +1,175 @@
+#include "set.h"
+#include <stdint.h>
+
+
+/*
+ * Return the hash of device 'dev' and inode 'ino'.
+ */
+static size_t jctl_set_hash (jctl_size dev, jctl_size ino)
+{
+	uint64_t h = ino ^ (dev * 0x9E3779B97F4A7C15ULL);
+	h ^= h >> 33;
+	h *= 0xFF51AFD7ED558CCDULL;
+	h ^= h >> 33;
+	h *= 0xC4CEB9FE1A85EC53ULL;
+	h ^= h >> 33;
+	return (size_t) h;
+}
+
+
+/*
+ * Return the slot of device 'dev' and inode 'ino'
+ * in the 'cap' slots 'keys', or the empty slot it would go into.
+ * The slots are never full, so there always is one.
+ */
+static jctl_set_key *jctl_set_probe (jctl_set_key *keys, size_t cap, jctl_size dev, jctl_size ino)
+{
+	size_t mask = cap - 1;
+	size_t i = jctl_set_hash(dev, ino) & mask;
+
+	for(;; i = (i + 1) & mask)
+	{
+		jctl_set_key *k = keys + i;
+		if(k->ino == 0 || (k->ino == ino && k->dev == dev))
+			return k;
+	}
+}
+
+
+/*
+ * Initialize empty set 's'.
+ * Memory is only allocated by the first insert.
+ */
+void jctl_set_init (jctl_set *s)
+{
+	s->keys = NULL;
+	s->cap = 0;
+	s->count = 0;
+}
+
+
+/*
+ * Free the slots of set 's'.
+ */
+void jctl_set_free (jctl_set *s)
+{
+	free(s->keys);
+	jctl_set_init(s);
+}
+
+
+/*
+ * Double the capacity of set 's'.
+ * Return 0 on success, otherwise (out of memory) return 1.
+ */
+static int jctl_set_grow (jctl_set *s)
+{
+	size_t cap = s->cap ? s->cap * 2 : JCTL_SET_MIN;
+	jctl_set_key *keys = (jctl_set_key*)calloc(cap, sizeof(*keys));
+	if(keys == NULL)
+		return 1;
+
+	for(size_t i = 0; i < s->cap; ++i)
+		if(s->keys[i].ino != 0)
+			*jctl_set_probe(keys, cap, s->keys[i].dev, s->keys[i].ino) = s->keys[i];
+
+	free(s->keys);
+	s->keys = keys;
+	s->cap = cap;
+	return 0;
+}
+
+
+/*
+ * Insert the file of device 'dev' and inode 'ino' into set 's',
+ * 'ino' must not be 0.
+ * Return 1 if it got inserted, 0 if it was in the set already
+ * and -1 if it couldn't be inserted (out of memory).
+ */
+int jctl_set_insert (jctl_set *s, jctl_size dev, jctl_size ino)
+{
+	/* stay at most half full */
+	if((s->count + 1) * 2 > s->cap && jctl_set_grow(s))
+		return -1;
+
+	jctl_set_key *k = jctl_set_probe(s->keys, s->cap, dev, ino);
+	if(k->ino != 0)
+		return 0;
+
+	k->dev = dev;
+	k->ino = ino;
+	++s->count;
+	return 1;
+}
+
+
+/*
+ * Check if the file of device 'dev' and inode 'ino' is in set 's'.
+ * Return 1 if it is, otherwise return 0.
+ */
+jctl_uint jctl_set_contains (jctl_set *s, jctl_size dev, jctl_size ino)
+{
+	if(s->count == 0 || ino == 0)
+		return 0;
+	return (jctl_set_probe(s->keys, s->cap, dev, ino)->ino != 0);
+}
+
+
+/*
+ * Initialize empty shared set 's'.
+ */
+void jctl_set_shared_init (jctl_set_shared *s)
+{
+	for(jctl_uint i = 0; i < JCTL_SET_SHARDS; ++i)
+	{
+		pthread_mutex_init(&s->shards[i].lock, NULL);
+		jctl_set_init(&s->shards[i].set);
+	}
+}
+
+
+/*
+ * Free the shards of shared set 's'.
+ */
+void jctl_set_shared_free (jctl_set_shared *s)
+{
+	for(jctl_uint i = 0; i < JCTL_SET_SHARDS; ++i)
+	{
+		jctl_set_free(&s->shards[i].set);
+		pthread_mutex_destroy(&s->shards[i].lock);
+	}
+}
+
+
+/*
+ * Insert the file of device 'dev' and inode 'ino' into shared set 's',
+ * like 'jctl_set_insert', safe to call from any thread.
+ * The shard is picked by the high bits of the hash,
+ * the slot within it by the low ones.
+ */
+int jctl_set_shared_insert (jctl_set_shared *s, jctl_size dev, jctl_size ino)
+{
+	jctl_set_shard *sh = s->shards + ((uint64_t) jctl_set_hash(dev, ino) >> 32) % JCTL_SET_SHARDS;
+
+	pthread_mutex_lock(&sh->lock);
+	int r = jctl_set_insert(&sh->set, dev, ino);
+	pthread_mutex_unlock(&sh->lock);
+
+	return r;
+}
+
+
+/*
+ * Check if the file of device 'dev' and inode 'ino' is in shared set 's',
+ * like 'jctl_set_contains', safe to call from any thread.
+ */
+jctl_uint jctl_set_shared_contains (jctl_set_shared *s, jctl_size dev, jctl_size ino)
+{
+	jctl_set_shard *sh = s->shards + ((uint64_t) jctl_set_hash(dev, ino) >> 32) % JCTL_SET_SHARDS;
+
+	pthread_mutex_lock(&sh->lock);
+	jctl_uint r = jctl_set_contains(&sh->set, dev, ino);
+	pthread_mutex_unlock(&sh->lock);
+
+	return r;
+}
@@ -0,0 +1,87 @@
+#ifndef JCTL_SET_H
+#define JCTL_SET_H
+
+#include "jctl.h"
+#include <pthread.h>
+
+
+/*
+ * Initial capacity of a set,
+ * has to be a power of two.
+ */
+#define JCTL_SET_MIN	(64)
+
+/*
+ * Amount of shards of a shared set,
+ * has to be a power of two.
+ */
+#define JCTL_SET_SHARDS	(64)
+
+
+/*
+*
+* Set Key
+*
+* Identifies a file by its device and inode,
+* a key of inode 0 marks an empty slot.
+*
+*/
+typedef struct jctl_set_key_s
+{
+	jctl_size dev;		/* device */
+	jctl_size ino;		/* inode */
+} jctl_set_key;
+
+
+/*
+*
+* Set
+*
+* Open addressing hash set of files,
+* used to find files and directories seen before.
+* Not thread safe by itself.
+*
+*/
+typedef struct jctl_set_s
+{
+	jctl_set_key *keys;	/* slots */
+	size_t cap;			/* slot count, a power of two */
+	size_t count;		/* used slots */
+} jctl_set;
+
+
+/*
+*
+* Shared Set
+*
+* Set of files split into shards by the hash of their key,
+* every shard with a lock of its own,
+* so threads inserting different files rarely wait for each other.
+*
+*/
+typedef struct jctl_set_shard_s
+{
+	pthread_mutex_t lock;	/* shard lock */
+	jctl_set set;			/* keys of the shard */
+} jctl_set_shard;
+
+typedef struct jctl_set_shared_s
+{
+	jctl_set_shard shards[JCTL_SET_SHARDS];	/* shards */
+} jctl_set_shared;
+
+
+void		jctl_set_init		(jctl_set *s);
+void		jctl_set_free		(jctl_set *s);
+
+int			jctl_set_insert		(jctl_set *s, jctl_size dev, jctl_size ino);
+jctl_uint	jctl_set_contains	(jctl_set *s, jctl_size dev, jctl_size ino);
+
+void		jctl_set_shared_init	(jctl_set_shared *s);
+void		jctl_set_shared_free	(jctl_set_shared *s);
+
+int			jctl_set_shared_insert	(jctl_set_shared *s, jctl_size dev, jctl_size ino);
+jctl_uint	jctl_set_shared_contains	(jctl_set_shared *s, jctl_size dev, jctl_size ino);
+
+
+#endif /* JCTL_SET_H */
@@ -0,0 +1,447 @@
+#define _FILE_OFFSET_BITS 64
+
+#include "snap.h"
+#include "rollup.h"
+#include "sort.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+	#include <io.h>
+	#include <process.h>
+	#define getpid _getpid
+#else
+	#include <unistd.h>
+#endif
+
+#if defined(__unix__) || (defined(__APPLE__) && defined(__MACH__))
+	#define JCTL_SNAP_MMAP
+	#include <sys/mman.h>
+#endif
+
+#ifndef O_BINARY
+	#define O_BINARY (0)
+#endif
+
+
+static const char jctl_snap_magic[8] = "JCTLSNP";
+
+
+/*
+ * Return the 32 bit little endian number at 'p'.
+ */
+static inline uint32_t jctl_snap_le32 (const unsigned char *p)
+{
+	return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+
+/*
+ * Return the 64 bit little endian number at 'p'.
+ */
+static inline uint64_t jctl_snap_le64 (const unsigned char *p)
+{
+	return (uint64_t) jctl_snap_le32(p) | ((uint64_t) jctl_snap_le32(p + 4) << 32);
+}
+
+
+/*
+ * Compare paths 'a' of length 'alen' and 'b' of length 'blen'
+ * like 'strcmp' does.
+ */
+static inline int jctl_snap_compare (const char *a, size_t alen, const char *b, size_t blen)
+{
+	int c = memcmp(a, b, (alen < blen) ? alen : blen);
+	if(c != 0)
+		return c;
+	return (alen > blen) - (alen < blen);
+}
+
+
+/*
+ * Start writing snapshot file 'fn' with writer 'w',
+ * into a temporary file next to it.
+ * Return 0 on success, otherwise (the file can't be created,
+ * or out of memory) return 1.
+ */
+jctl_uint jctl_snap_create (jctl_snap_writer *w, const char *fn)
+{
+	size_t len = strlen(fn) + 32;
+	w->fn = (char*)malloc(len);
+	w->tmp = (char*)malloc(len);
+	if(w->fn == NULL || w->tmp == NULL)
+		goto fail;
+
+	memcpy(w->fn, fn, strlen(fn) + 1);
+	snprintf(w->tmp, len, "%s.%ld", fn, (long) getpid());
+
+	int fd = open(w->tmp, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0644);
+	if(fd < 0)
+		goto fail;
+
+	if(jctl_out_init(&w->o, fd, JCTL_OUT_BUFSIZE))
+	{
+		close(fd);
+		remove(w->tmp);
+		goto fail;
+	}
+
+	jctl_emit_header(&w->o, jctl_snap_magic, JCTL_SNAP_VERSION);
+	return 0;
+
+fail:
+	free(w->fn);
+	free(w->tmp);
+	return 1;
+}
+
+
+/*
+ * Add the record of a file to snapshot writer 'w',
+ * of path 'path' of length 'len' with directory length 'dirlen',
+ * 'lines' lines and 'bytes' bytes.
+ * Records have to be added sorted by path.
+ */
+void jctl_snap_add (jctl_snap_writer *w, const char *path, size_t len, jctl_size lines, jctl_size bytes, jctl_uint dirlen)
+{
+	jctl_emit_entry(&w->o, JCTL_EMIT_BIN, path, len, lines, bytes, dirlen);
+}
+
+
+/*
+ * Finish the snapshot of writer 'w', renaming it over the snapshot file.
+ * Return 0 on success, otherwise (a write failed) return 1,
+ * the temporary file gets removed then.
+ */
+jctl_uint jctl_snap_finish (jctl_snap_writer *w)
+{
+	int err = jctl_out_flush(&w->o);
+	err |= (close(w->o.fd) != 0);
+	jctl_out_free(&w->o);
+
+#ifdef _WIN32
+	/* rename doesn't replace files on Windows */
+	if(!err)
+		remove(w->fn);
+#endif /* defined(_WIN32) */
+
+	if(!err)
+		err = (rename(w->tmp, w->fn) != 0);
+	if(err)
+		remove(w->tmp);
+
+	free(w->fn);
+	free(w->tmp);
+	return err;
+}
+
+
+/*
+ * Open snapshot file 'fn' as snapshot 's', mapped into memory.
+ * Return 0 on success, otherwise (the file can't be read,
+ * or isn't a snapshot of this version) return 1.
+ */
+jctl_uint jctl_snap_open (jctl_snap *s, const char *fn)
+{
+	s->map = NULL;
+	s->size = 0;
+	s->off = 0;
+	s->prev = NULL;
+	s->prevlen = 0;
+	s->err = 0;
+
+	int fd = open(fn, O_RDONLY | O_BINARY);
+	if(fd < 0)
+		return 1;
+
+	struct stat st;
+	if(fstat(fd, &st) != 0 || st.st_size < JCTL_EMIT_BIN_HEADER || (uintmax_t) st.st_size > SIZE_MAX)
+	{
+		close(fd);
+		return 1;
+	}
+
+	size_t size = (size_t) st.st_size;
+
+#ifdef JCTL_SNAP_MMAP
+	void *p = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if(p == MAP_FAILED)
+		p = NULL;
+#else
+	void *p = malloc(size);
+	for(size_t off = 0; p != NULL && off < size;)
+	{
+		int n = read(fd, (char*) p + off, (unsigned int)(size - off));
+		if(n <= 0)
+		{
+			free(p);
+			p = NULL;
+		}
+		else
+			off += n;
+	}
+#endif /* defined(JCTL_SNAP_MMAP) */
+
+	close(fd);
+	if(p == NULL)
+		return 1;
+
+	s->map = (const unsigned char*) p;
+	s->size = size;
+
+	uint32_t hsize = jctl_snap_le32(s->map + 12);
+	if(memcmp(s->map, jctl_snap_magic, sizeof(jctl_snap_magic)) != 0
+	|| jctl_snap_le32(s->map + 8) != JCTL_SNAP_VERSION
+	|| hsize < JCTL_EMIT_BIN_HEADER || hsize > size)
+	{
+		jctl_snap_close(s);
+		return 1;
+	}
+
+	s->off = hsize;
+	return 0;
+}
+
+
+/*
+ * Close snapshot 's'.
+ */
+void jctl_snap_close (jctl_snap *s)
+{
+	if(s->map == NULL)
+		return;
+
+#ifdef JCTL_SNAP_MMAP
+	munmap((void*) s->map, s->size);
+#else
+	free((void*) s->map);
+#endif /* defined(JCTL_SNAP_MMAP) */
+
+	s->map = NULL;
+}
+
+
+/*
+ * Read the next record of snapshot 's' into 'r'.
+ * Return 1 if there was one, otherwise return 0,
+ * with 's->err' set if a damaged record or one out of order ended it.
+ */
+jctl_uint jctl_snap_next (jctl_snap *s, jctl_snap_rec *r)
+{
+	size_t fixed = sizeof(jctl_emit_record);
+
+	if(s->err || s->off >= s->size)
+		return 0;
+
+	const unsigned char *p = s->map + s->off;
+	size_t left = s->size - s->off;
+	if(left < fixed)
+	{
+		s->err = 1;
+		return 0;
+	}
+
+	size_t size = jctl_snap_le32(p + offsetof(jctl_emit_record, size));
+	r->len = jctl_snap_le32(p + offsetof(jctl_emit_record, pathlen));
+	r->lines = jctl_snap_le64(p + offsetof(jctl_emit_record, lines));
+	r->bytes = jctl_snap_le64(p + offsetof(jctl_emit_record, bytes));
+	r->dirlen = jctl_snap_le32(p + offsetof(jctl_emit_record, dirlen));
+	r->path = (const char*)(p + fixed);
+
+	/* the path is only looked at once it's known to lie within the record */
+	if(size < fixed || size > left || size % JCTL_EMIT_BIN_ALIGN != 0 || r->len >= size - fixed
+	|| r->path[r->len] != '\0' || r->dirlen > r->len
+	|| (s->prev != NULL && jctl_snap_compare(s->prev, s->prevlen, r->path, r->len) >= 0))
+	{
+		s->err = 1;
+		return 0;
+	}
+
+	s->prev = r->path;
+	s->prevlen = r->len;
+	s->off += size;
+	return 1;
+}
+
+
+/*
+ * Add the signed line count 'delta' to the output of writer 'o',
+ * with its unit.
+ */
+static void jctl_snap_print_delta (jctl_out *o, jctl_size delta)
+{
+	jctl_size abs = ((int64_t) delta < 0) ? -delta : delta;
+	jctl_out_write(o, ((int64_t) delta < 0) ? "-" : "+", 1);
+	jctl_out_uint(o, abs);
+	if(abs == 1)
+		jctl_out_write(o, " line", 5);
+	else
+		jctl_out_write(o, " lines", 6);
+}
+
+
+/*
+ * Add the line of file record 'r' to the output of writer 'o',
+ * marked by 'mark', followed by its line count.
+ */
+static void jctl_snap_print_rec (jctl_out *o, char mark, jctl_snap_rec *r)
+{
+	jctl_out_write(o, &mark, 1);
+	jctl_out_write(o, " ", 1);
+	jctl_out_write(o, r->path, r->len);
+	jctl_out_write(o, " | ", 3);
+	jctl_out_uint(o, r->lines);
+	jctl_out_write(o, (r->lines == 1) ? " line\n" : " lines\n", (r->lines == 1) ? 6 : 7);
+}
+
+
+/*
+ * Print the directories of roll-up 'r', summing up line deltas,
+ * sorted by name with writer 'o'.
+ * Return 0 on success, otherwise (out of memory) return 1.
+ */
+static jctl_uint jctl_snap_print_dirs (jctl_rollup *r, jctl_out *o)
+{
+	jctl_sort_str *k = (jctl_sort_str*)malloc(sizeof(*k) * (r->count + 1));
+	if(k == NULL)
+		return 1;
+
+	size_t n = 0;
+	size_t width = 0;
+	for(size_t i = 0; i < r->cap; ++i)
+	{
+		jctl_rollup_slot *sl = r->slots + i;
+		if(sl->key == NULL)
+			continue;
+		k[n].s = sl->key;
+		k[n].i = (jctl_uint) i;
+		++n;
+		if(sl->len > width)
+			width = sl->len;
+	}
+
+	jctl_sort_strs(k, n);
+
+	for(size_t i = 0; i < n; ++i)
+	{
+		jctl_rollup_slot *sl = r->slots + k[i].i;
+		jctl_out_write(o, sl->key, sl->len);
+		jctl_out_fill(o, ' ', width - sl->len);
+		jctl_out_write(o, " | ", 3);
+		jctl_snap_print_delta(o, sl->lines);
+		jctl_out_write(o, "\n", 1);
+	}
+
+	free(k);
+	return 0;
+}
+
+
+/*
+ * Compare snapshot 'from' to the later snapshot 'to',
+ * printing the differences with writer 'o'.
+ *
+ * Both are sorted by path, so they are merged in one pass:
+ * files only in 'to' are added ("+"), those only in 'from' removed ("-"),
+ * those of other line count or size changed ("~").
+ * The line deltas are summed up by directory, every directory
+ * including the ones below it, and printed after the files.
+ * Line deltas are summed up modulo 2^64 in the unsigned roll-up,
+ * which makes them come out right as signed numbers.
+ *
+ * Return 0 on success, 1 if out of memory,
+ * otherwise (a snapshot is damaged) return 2.
+ */
+jctl_uint jctl_snap_diff (jctl_snap *from, jctl_snap *to, jctl_out *o)
+{
+	jctl_rollup dirs;
+	jctl_rollup_init(&dirs);
+
+	jctl_size added = 0, removed = 0, changed = 0, delta = 0;
+	jctl_uint err = 0;
+
+	jctl_snap_rec a, b;
+	jctl_uint ha = jctl_snap_next(from, &a);
+	jctl_uint hb = jctl_snap_next(to, &b);
+
+	while((ha || hb) && !err)
+	{
+		int c = !ha ? 1 : !hb ? -1 : jctl_snap_compare(a.path, a.len, b.path, b.len);
+		jctl_snap_rec *r = (c > 0) ? &b : &a;
+		jctl_size d = 0;
+
+		if(c < 0)
+		{
+			jctl_snap_print_rec(o, '-', &a);
+			d = -a.lines;
+			++removed;
+		}
+		else if(c > 0)
+		{
+			jctl_snap_print_rec(o, '+', &b);
+			d = b.lines;
+			++added;
+		}
+		else if(a.lines != b.lines || a.bytes != b.bytes)
+		{
+			d = b.lines - a.lines;
+			jctl_out_write(o, "~ ", 2);
+			jctl_out_write(o, b.path, b.len);
+			jctl_out_write(o, " | ", 3);
+			jctl_out_uint(o, a.lines);
+			jctl_out_write(o, " -> ", 4);
+			jctl_out_uint(o, b.lines);
+			jctl_out_write(o, " (", 2);
+			jctl_snap_print_delta(o, d);
+			jctl_out_write(o, ")\n", 2);
+			++changed;
+		}
+
+		if(c < 0 || c > 0 || a.lines != b.lines || a.bytes != b.bytes)
+		{
+			size_t len;
+			const char *dir = jctl_rollup_dir(r->path, r->dirlen, 0, &len);
+			err = jctl_rollup_add(&dirs, dir, len, d);
+			delta += d;
+		}
+
+		if(c <= 0)
+			ha = jctl_snap_next(from, &a);
+		if(c >= 0)
+			hb = jctl_snap_next(to, &b);
+	}
+
+	if(!err && dirs.count > 0)
+	{
+		err = jctl_rollup_parents(&dirs);
+		if(!err)
+		{
+			jctl_out_write(o, "\n", 1);
+			err = jctl_snap_print_dirs(&dirs, o);
+		}
+	}
+
+	if(!err)
+	{
+		if(added + removed + changed > 0)
+			jctl_out_write(o, "\n", 1);
+		jctl_out_uint(o, added);
+		jctl_out_write(o, " added, ", 8);
+		jctl_out_uint(o, removed);
+		jctl_out_write(o, " removed, ", 10);
+		jctl_out_uint(o, changed);
+		jctl_out_write(o, " changed, ", 10);
+		jctl_snap_print_delta(o, delta);
+		jctl_out_write(o, "\n", 1);
+	}
+
+	jctl_rollup_free(&dirs);
+
+	if(err)
+		return 1;
+	return (from->err || to->err) ? 2 : 0;
+}
@@ -0,0 +1,83 @@
+#ifndef JCTL_SNAP_H
+#define JCTL_SNAP_H
+
+#include "jctl.h"
+#include "out.h"
+#include "emit.h"
+#include <stddef.h>
+
+
+/*
+ * Snapshot file format version,
+ * snapshots of any other version are refused.
+ */
+#define JCTL_SNAP_VERSION	(1)
+
+
+/*
+*
+* Snapshot
+*
+* Counted files of a run, saved by '--save-snapshot'.
+* A header like the one of the binary output format, but for the magic
+* "JCTLSNP", followed by its records ('jctl_emit_record') sorted by path
+* like 'strcmp' orders them, so two snapshots are compared in one pass.
+* Read mapped into memory, records are used where they are.
+*
+*/
+typedef struct jctl_snap_s
+{
+	const unsigned char *map;	/* mapped file */
+	size_t size;				/* file size */
+	size_t off;					/* offset of the next record */
+	const char *prev;			/* path of the last record, for checking the order */
+	size_t prevlen;				/* its length */
+	jctl_uint err;				/* a damaged or unsorted record ended the reading */
+} jctl_snap;
+
+
+/*
+*
+* Snapshot Record
+*
+* Fields of a record of a snapshot, its path points into the mapping.
+*
+*/
+typedef struct jctl_snap_rec_s
+{
+	const char *path;	/* path, terminated */
+	size_t len;			/* path length */
+	jctl_size lines;	/* line count */
+	jctl_size bytes;	/* file size */
+	size_t dirlen;		/* directory length of the path */
+} jctl_snap_rec;
+
+
+/*
+*
+* Snapshot Writer
+*
+* Writes a temporary file renamed over the snapshot once complete,
+* so a failed run leaves an older snapshot as it was.
+*
+*/
+typedef struct jctl_snap_writer_s
+{
+	jctl_out o;		/* writer of the temporary file */
+	char *fn;		/* snapshot file name */
+	char *tmp;		/* temporary file name */
+} jctl_snap_writer;
+
+
+jctl_uint	jctl_snap_create	(jctl_snap_writer *w, const char *fn);
+void		jctl_snap_add		(jctl_snap_writer *w, const char *path, size_t len, jctl_size lines, jctl_size bytes, jctl_uint dirlen);
+jctl_uint	jctl_snap_finish	(jctl_snap_writer *w);
+
+jctl_uint	jctl_snap_open		(jctl_snap *s, const char *fn);
+void		jctl_snap_close		(jctl_snap *s);
+jctl_uint	jctl_snap_next		(jctl_snap *s, jctl_snap_rec *r);
+
+jctl_uint	jctl_snap_diff		(jctl_snap *from, jctl_snap *to, jctl_out *o);
+
+
+#endif /* JCTL_SNAP_H */
@@ -0,0 +1,193 @@
+#include "sort.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+/*
+ * Sort the 'n' keys of 'k' by increasing key,
+ * with a least significant digit radix sort of one byte per pass.
+ * Keys of equal value keep their order.
+ * Passes over a byte all keys share are skipped,
+ * line counts rarely need more than three of the eight.
+ * Return 0 on success, otherwise (out of memory) return 1.
+ */
+jctl_uint jctl_sort_keys (jctl_sort_key *k, size_t n)
+{
+	if(n < 2)
+		return 0;
+
+	jctl_sort_key *tmp = (jctl_sort_key*)malloc(sizeof(*tmp) * n);
+	if(tmp == NULL)
+		return 1;
+
+	/* the histograms of all bytes in one go */
+	size_t (*count)[256] = (size_t(*)[256])calloc(8, sizeof(*count));
+	if(count == NULL)
+	{
+		free(tmp);
+		return 1;
+	}
+
+	for(size_t i = 0; i < n; ++i)
+		for(jctl_uint b = 0; b < 8; ++b)
+			++count[b][(k[i].key >> (b * 8)) & 0xFF];
+
+	jctl_sort_key *from = k;
+	jctl_sort_key *to = tmp;
+
+	for(jctl_uint b = 0; b < 8; ++b)
+	{
+		if(count[b][(k[0].key >> (b * 8)) & 0xFF] == n)
+			continue;
+
+		size_t pos = 0;
+		for(jctl_uint d = 0; d < 256; ++d)
+		{
+			size_t c = count[b][d];
+			count[b][d] = pos;
+			pos += c;
+		}
+
+		for(size_t i = 0; i < n; ++i)
+			to[count[b][(from[i].key >> (b * 8)) & 0xFF]++] = from[i];
+
+		jctl_sort_key *swap = from;
+		from = to;
+		to = swap;
+	}
+
+	if(from != k)
+		memcpy(k, from, sizeof(*k) * n);
+
+	free(count);
+	free(tmp);
+	return 0;
+}
+
+
+/*
+ * Return the 8 bytes of string 's' starting at 'depth' in big endian,
+ * so they compare as numbers like the string does byte by byte.
+ * Bytes past the end of the string are 0,
+ * the string ended if the lowest byte is.
+ */
+static inline uint64_t jctl_sort_prefix (const char *s, size_t depth)
+{
+	uint64_t p = 0;
+	const unsigned char *u = (const unsigned char*) s + depth;
+	jctl_uint end = 0;
+	for(jctl_uint b = 0; b < 8; ++b)
+	{
+		unsigned char c = end ? 0 : u[b];
+		end = (c == '\0');
+		p = (p << 8) | c;
+	}
+	return p;
+}
+
+
+/*
+ * Compare strings 'a' and 'b', which are equal before 'depth'
+ * and have their prefixes cached at it.
+ */
+static inline int jctl_sort_str_compare (const jctl_sort_str *a, const jctl_sort_str *b, size_t depth)
+{
+	if(a->prefix != b->prefix)
+		return (a->prefix > b->prefix) ? 1 : -1;
+	if((a->prefix & 0xFF) == 0)
+		return 0;
+	return strcmp(a->s + depth + 8, b->s + depth + 8);
+}
+
+
+/*
+ * Swap strings 'a' and 'b'.
+ */
+static inline void jctl_sort_str_swap (jctl_sort_str *a, jctl_sort_str *b)
+{
+	jctl_sort_str t = *a;
+	*a = *b;
+	*b = t;
+}
+
+
+/*
+ * Sort the 'n' strings of 'k', equal before 'depth',
+ * with a multikey quicksort over their cached prefixes.
+ *
+ * The strings are split three ways by the prefix of a pivot,
+ * the ones less and greater get sorted at the same depth,
+ * the equal ones 8 bytes deeper, unless they ended.
+ * The biggest part is sorted in the loop, the others are recursed into,
+ * which keeps the recursion shallow.
+ */
+static void jctl_sort_strs_at (jctl_sort_str *k, size_t n, size_t depth)
+{
+	while(n > JCTL_SORT_SMALL)
+	{
+		/* median of three as pivot */
+		uint64_t a = k[0].prefix, b = k[n / 2].prefix, c = k[n - 1].prefix;
+		uint64_t pivot = (a < b) ? ((b < c) ? b : (a < c) ? c : a) : ((a < c) ? a : (b < c) ? c : b);
+
+		/* [0, lt) less, [lt, gt) equal, [gt, n) greater */
+		size_t lt = 0, i = 0, gt = n;
+		while(i < gt)
+		{
+			if(k[i].prefix < pivot)
+				jctl_sort_str_swap(k + lt++, k + i++);
+			else if(k[i].prefix > pivot)
+				jctl_sort_str_swap(k + i, k + --gt);
+			else
+				++i;
+		}
+
+		/* equal strings that ended are sorted already */
+		size_t neq = ((pivot & 0xFF) != 0) ? gt - lt : 0;
+		size_t ngt = n - gt;
+		for(size_t j = lt; j < lt + neq; ++j)
+			k[j].prefix = jctl_sort_prefix(k[j].s, depth + 8);
+
+		if(neq >= lt && neq >= ngt)
+		{
+			jctl_sort_strs_at(k, lt, depth);
+			jctl_sort_strs_at(k + gt, ngt, depth);
+			k += lt;
+			n = neq;
+			depth += 8;
+		}
+		else if(lt >= ngt)
+		{
+			jctl_sort_strs_at(k + lt, neq, depth + 8);
+			jctl_sort_strs_at(k + gt, ngt, depth);
+			n = lt;
+		}
+		else
+		{
+			jctl_sort_strs_at(k, lt, depth);
+			jctl_sort_strs_at(k + lt, neq, depth + 8);
+			k += gt;
+			n = ngt;
+		}
+	}
+
+	for(size_t i = 1; i < n; ++i)
+	{
+		jctl_sort_str t = k[i];
+		size_t j = i;
+		for(; j > 0 && jctl_sort_str_compare(&t, k + j - 1, depth) < 0; --j)
+			k[j] = k[j - 1];
+		k[j] = t;
+	}
+}
+
+
+/*
+ * Sort the 'n' strings of 'k' like 'strcmp' orders them.
+ * Their prefixes get cached here.
+ */
+void jctl_sort_strs (jctl_sort_str *k, size_t n)
+{
+	for(size_t i = 0; i < n; ++i)
+		k[i].prefix = jctl_sort_prefix(k[i].s, 0);
+	jctl_sort_strs_at(k, n, 0);
+}
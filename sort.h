@@ -0,0 +1,53 @@
+#ifndef JCTL_SORT_H
+#define JCTL_SORT_H
+
+#include "jctl.h"
+#include <stddef.h>
+#include <stdint.h>
+
+
+/*
+ * Ranges of at most JCTL_SORT_SMALL strings
+ * are sorted by insertion instead of partitioning them further.
+ */
+#define JCTL_SORT_SMALL	(16)
+
+
+/*
+*
+* Sort Key
+*
+* Number to sort by and the index of what it belongs to,
+* sorted by 'jctl_sort_keys'.
+*
+*/
+typedef struct jctl_sort_key_s
+{
+	jctl_size key;		/* key */
+	jctl_uint i;		/* index */
+} jctl_sort_key;
+
+
+/*
+*
+* Sort String
+*
+* String to sort by and the index of what it belongs to,
+* sorted by 'jctl_sort_strs'.
+* 'prefix' caches the 8 bytes of the string at the depth
+* sorted at, so most comparisons don't touch the string.
+*
+*/
+typedef struct jctl_sort_str_s
+{
+	uint64_t prefix;	/* bytes at the current depth, big endian */
+	const char *s;		/* string */
+	jctl_uint i;		/* index */
+} jctl_sort_str;
+
+
+jctl_uint	jctl_sort_keys	(jctl_sort_key *k, size_t n);
+void		jctl_sort_strs	(jctl_sort_str *k, size_t n);
+
+
+#endif /* JCTL_SORT_H */
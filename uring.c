@@ -0,0 +1,444 @@
+/* O_NOATIME */
+#ifdef __linux__
+	#define _GNU_SOURCE
+#endif
+
+#include "uring.h"
+#include "count.h"
+#include "file.h"
+
+#if defined(__linux__) && defined(__has_include)
+	#if __has_include(<linux/io_uring.h>)
+		#include <linux/io_uring.h>
+		/* direct descriptors (file_index) came with 5.15 headers */
+		#ifdef IORING_SETUP_COOP_TASKRUN
+			#define JCTL_URING
+		#endif
+	#endif
+#endif
+
+
+#ifdef JCTL_URING
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+/*
+ * Submissions per file: openat, read and close.
+ */
+#define JCTL_URING_OPS (3)
+
+/*
+ * Flags files get opened with, avoiding access time updates
+ * like 'jctl_file_open' where allowed.
+ */
+#ifdef O_NOATIME
+	#define JCTL_URING_OPEN	(O_RDONLY | O_NOATIME)
+#else
+	#define JCTL_URING_OPEN	(O_RDONLY)
+#endif
+
+
+struct jctl_uring_s
+{
+	int fd;							/* ring file descriptor */
+	unsigned sqentries;				/* submission ring size */
+
+	/* submission ring */
+	unsigned *sqhead;
+	unsigned *sqtail;
+	unsigned *sqmask;
+	unsigned *sqarray;
+	struct io_uring_sqe *sqes;
+
+	/* completion ring */
+	unsigned *cqhead;
+	unsigned *cqtail;
+	unsigned *cqmask;
+	struct io_uring_cqe *cqes;
+
+	/* mappings */
+	void *sqring;
+	void *cqring;
+	size_t sqringsize;
+	size_t cqringsize;
+	size_t sqessize;
+
+	char *slots;					/* read buffer of every slot */
+	int dead;						/* a submission failed, the ring isn't used anymore */
+};
+
+
+/*
+ * Return the next free submission of ring 'r', cleared,
+ * or NULL if the submission ring is full.
+ * Submissions get published by storing 'tail' to the ring.
+ */
+static struct io_uring_sqe *jctl_uring_sqe (jctl_uring *r, unsigned *tail)
+{
+	unsigned head = __atomic_load_n(r->sqhead, __ATOMIC_ACQUIRE);
+	if(*tail - head >= r->sqentries)
+		return NULL;
+
+	unsigned idx = *tail & *r->sqmask;
+	struct io_uring_sqe *sqe = r->sqes + idx;
+	memset(sqe, 0, sizeof(*sqe));
+	r->sqarray[idx] = idx;
+	++*tail;
+
+	return sqe;
+}
+
+
+/*
+ * Submit 'n' published submissions of ring 'r'
+ * and wait for at least 'wait' completions.
+ * Return the amount submitted, or -1 on failure.
+ */
+static int jctl_uring_enter (jctl_uring *r, unsigned n, unsigned wait)
+{
+	for(;;)
+	{
+		long ret = syscall(__NR_io_uring_enter, r->fd, n, wait, wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+		if(ret >= 0)
+			return (int) ret;
+		if(errno != EINTR && errno != EAGAIN && errno != EBUSY)
+			return -1;
+	}
+}
+
+
+/*
+ * Free ring 'r'.
+ */
+void jctl_uring_free (jctl_uring *r)
+{
+	if(r == NULL)
+		return;
+
+	if(r->sqes != NULL && r->sqes != MAP_FAILED)
+		munmap(r->sqes, r->sqessize);
+	if(r->cqring != NULL && r->cqring != MAP_FAILED && r->cqring != r->sqring)
+		munmap(r->cqring, r->cqringsize);
+	if(r->sqring != NULL && r->sqring != MAP_FAILED)
+		munmap(r->sqring, r->sqringsize);
+	if(r->fd >= 0)
+		close(r->fd);
+
+	/* reads of a dead ring may still be in flight into the slots */
+	if(!r->dead)
+		free(r->slots);
+	free(r);
+}
+
+
+/*
+ * Check that the kernel supports opening and closing
+ * straight into the registered file table of ring 'r'.
+ * Return 0 if it does, otherwise return 1.
+ */
+static int jctl_uring_probe (jctl_uring *r)
+{
+	unsigned tail = *r->sqtail;
+
+	struct io_uring_sqe *sqe = jctl_uring_sqe(r, &tail);
+	sqe->opcode = IORING_OP_OPENAT;
+	sqe->fd = AT_FDCWD;
+	sqe->addr = (unsigned long) ".";
+	sqe->open_flags = O_RDONLY | O_DIRECTORY;
+	sqe->file_index = 1;
+	sqe->flags = IOSQE_IO_LINK;
+
+	sqe = jctl_uring_sqe(r, &tail);
+	sqe->opcode = IORING_OP_CLOSE;
+	sqe->file_index = 1;
+
+	__atomic_store_n(r->sqtail, tail, __ATOMIC_RELEASE);
+
+	int err = 0;
+	unsigned submit = 2;
+	for(unsigned done = 0; done < 2;)
+	{
+		int ret = jctl_uring_enter(r, submit, 1);
+		if(ret < 0)
+			return 1;
+		submit -= ret;
+
+		unsigned head = *r->cqhead;
+		unsigned cqtail = __atomic_load_n(r->cqtail, __ATOMIC_ACQUIRE);
+		for(; head != cqtail; ++head, ++done)
+			err |= (r->cqes[head & *r->cqmask].res < 0);
+		__atomic_store_n(r->cqhead, head, __ATOMIC_RELEASE);
+	}
+
+	return err;
+}
+
+
+/*
+ * Create a new ring with a read slot for JCTL_URING_SLOTS files.
+ * Return the ring, or NULL if io_uring isn't usable.
+ */
+jctl_uring *jctl_uring_new (void)
+{
+	jctl_uring *r = (jctl_uring*)calloc(1, sizeof(*r));
+	if(r == NULL)
+		return NULL;
+
+	struct io_uring_params p;
+	memset(&p, 0, sizeof(p));
+
+	r->fd = (int) syscall(__NR_io_uring_setup, JCTL_URING_SLOTS * JCTL_URING_OPS, &p);
+	if(r->fd < 0)
+	{
+		free(r);
+		return NULL;
+	}
+
+	r->sqentries = p.sq_entries;
+	r->sqringsize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	r->cqringsize = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	r->sqessize = p.sq_entries * sizeof(struct io_uring_sqe);
+
+	/*
+	 * Newer kernels map both rings at once.
+	 */
+	if(p.features & IORING_FEAT_SINGLE_MMAP)
+	{
+		if(r->cqringsize > r->sqringsize)
+			r->sqringsize = r->cqringsize;
+		r->cqringsize = r->sqringsize;
+	}
+
+	r->sqring = mmap(NULL, r->sqringsize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQ_RING);
+	if(r->sqring == MAP_FAILED)
+		goto fail;
+
+	if(p.features & IORING_FEAT_SINGLE_MMAP)
+		r->cqring = r->sqring;
+	else
+	{
+		r->cqring = mmap(NULL, r->cqringsize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_CQ_RING);
+		if(r->cqring == MAP_FAILED)
+			goto fail;
+	}
+
+	r->sqes = (struct io_uring_sqe*)mmap(NULL, r->sqessize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQES);
+	if(r->sqes == MAP_FAILED)
+		goto fail;
+
+	char *sq = (char*) r->sqring;
+	r->sqhead  = (unsigned*)(sq + p.sq_off.head);
+	r->sqtail  = (unsigned*)(sq + p.sq_off.tail);
+	r->sqmask  = (unsigned*)(sq + p.sq_off.ring_mask);
+	r->sqarray = (unsigned*)(sq + p.sq_off.array);
+
+	char *cq = (char*) r->cqring;
+	r->cqhead = (unsigned*)(cq + p.cq_off.head);
+	r->cqtail = (unsigned*)(cq + p.cq_off.tail);
+	r->cqmask = (unsigned*)(cq + p.cq_off.ring_mask);
+	r->cqes   = (struct io_uring_cqe*)(cq + p.cq_off.cqes);
+
+	/*
+	 * Register an empty file table,
+	 * the files get opened straight into its slots.
+	 * Such direct descriptors never reach the file descriptor table,
+	 * so the kernel refuses O_CLOEXEC for them.
+	 */
+	int fds[JCTL_URING_SLOTS];
+	for(int i = 0; i < JCTL_URING_SLOTS; ++i)
+		fds[i] = -1;
+	if(syscall(__NR_io_uring_register, r->fd, IORING_REGISTER_FILES, fds, JCTL_URING_SLOTS) < 0)
+		goto fail;
+
+	if(jctl_uring_probe(r))
+		goto fail;
+
+	r->slots = (char*)malloc((size_t) JCTL_URING_SLOTS * JCTL_URING_SLOT);
+	if(r->slots == NULL)
+		goto fail;
+
+	return r;
+
+fail:
+	jctl_uring_free(r);
+	return NULL;
+}
+
+
+/*
+ * Queue the linked openat, read and close of file 'fn' into slot 'i'
+ * of ring 'r' at submission ring tail 'tail', opened with 'flags'.
+ * If the open fails the read gets cancelled,
+ * the close is hard linked so it always runs
+ * and the slot is free for the next batch.
+ */
+static void jctl_uring_queue (jctl_uring *r, unsigned *tail, char *fn, jctl_uint i, int flags)
+{
+	struct io_uring_sqe *sqe = jctl_uring_sqe(r, tail);
+	sqe->opcode = IORING_OP_OPENAT;
+	sqe->fd = AT_FDCWD;
+	sqe->addr = (unsigned long) fn;
+	sqe->open_flags = flags;
+	sqe->file_index = i + 1;
+	sqe->flags = IOSQE_IO_LINK;
+	sqe->user_data = i * JCTL_URING_OPS + 0;
+
+	sqe = jctl_uring_sqe(r, tail);
+	sqe->opcode = IORING_OP_READ;
+	sqe->fd = i;
+	sqe->addr = (unsigned long)(r->slots + (size_t) i * JCTL_URING_SLOT);
+	sqe->len = JCTL_URING_SLOT;
+	sqe->off = 0;
+	sqe->flags = IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK;
+	sqe->user_data = i * JCTL_URING_OPS + 1;
+
+	sqe = jctl_uring_sqe(r, tail);
+	sqe->opcode = IORING_OP_CLOSE;
+	sqe->file_index = i + 1;
+	sqe->user_data = i * JCTL_URING_OPS + 2;
+}
+
+
+/*
+ * Submit the 'total' submissions queued into ring 'r'
+ * and count the slot of every read as soon as it completes,
+ * into 'lc', clearing 'err' (see 'jctl_uring_linecount').
+ * 'perm[i]' is set for files whose open got refused with EPERM.
+ */
+static void jctl_uring_run (jctl_uring *r, unsigned total, const jctl_size *size, jctl_size *lc, jctl_uint *err, jctl_uint *perm)
+{
+	unsigned submit = total;
+
+	for(unsigned done = 0; done < total;)
+	{
+		int ret = jctl_uring_enter(r, submit, 1);
+		if(ret < 0)
+		{
+			r->dead = 1;
+			break;
+		}
+		submit -= ret;
+
+		unsigned head = *r->cqhead;
+		unsigned cqtail = __atomic_load_n(r->cqtail, __ATOMIC_ACQUIRE);
+
+		for(; head != cqtail; ++head, ++done)
+		{
+			struct io_uring_cqe *cqe = r->cqes + (head & *r->cqmask);
+			jctl_uint i = (jctl_uint)(cqe->user_data / JCTL_URING_OPS);
+			jctl_uint op = (jctl_uint)(cqe->user_data % JCTL_URING_OPS);
+
+			if(op == 0 && cqe->res == -EPERM)
+				perm[i] = 1;
+
+			/*
+			 * A full slot means the file might go on,
+			 * and one of another size than registered has changed since,
+			 * leave them to the usual path.
+			 */
+			if(op != 1 || cqe->res < 0 || cqe->res >= JCTL_URING_SLOT)
+				continue;
+			if(size[i] != JCTL_FILE_EOF && (jctl_size) cqe->res != size[i])
+				continue;
+
+			jctl_count c;
+			jctl_count_init(&c);
+			jctl_count_block(&c, r->slots + (size_t) i * JCTL_URING_SLOT, (size_t) cqe->res);
+			lc[i] = 1 + c.lc;
+			err[i] = 0;
+		}
+
+		__atomic_store_n(r->cqhead, head, __ATOMIC_RELEASE);
+	}
+}
+
+
+/*
+ * Count the lines of the 'n' files of names 'fn' using ring 'r',
+ * 'n' must not be more than JCTL_URING_SLOTS.
+ * 'size[i]' is the size file 'i' had when registered,
+ * JCTL_FILE_EOF if it isn't known.
+ *
+ * Every file is submitted as a linked openat, read and close,
+ * and its slot is counted as soon as the read completes.
+ * Files the user doesn't own refuse O_NOATIME,
+ * they get submitted once more without it.
+ * 'err[i]' is set to 1 for files that couldn't be counted this way
+ * (failed to open or read, bigger than a slot or not of their size),
+ * those have to be counted the usual way.
+ *
+ * If submitting or waiting fails, submissions may be left queued
+ * or in flight, and their completions would be taken for those
+ * of the next batch using the same slots. The ring is then dead,
+ * the files of this batch not counted yet and those of every
+ * later one are left to the usual way.
+ */
+void jctl_uring_linecount (jctl_uring *r, char **fn, const jctl_size *size, jctl_uint n, jctl_size *lc, jctl_uint *err)
+{
+	jctl_uint perm[JCTL_URING_SLOTS];
+
+	for(jctl_uint i = 0; i < n; ++i)
+	{
+		err[i] = 1;
+		lc[i] = 0;
+		perm[i] = 0;
+	}
+
+	if(r->dead)
+		return;
+
+	unsigned tail = *r->sqtail;
+	for(jctl_uint i = 0; i < n; ++i)
+		jctl_uring_queue(r, &tail, fn[i], i, JCTL_URING_OPEN);
+	__atomic_store_n(r->sqtail, tail, __ATOMIC_RELEASE);
+
+	jctl_uring_run(r, n * JCTL_URING_OPS, size, lc, err, perm);
+
+	if(r->dead || JCTL_URING_OPEN == O_RDONLY)
+		return;
+
+	jctl_uint m = 0;
+	tail = *r->sqtail;
+	for(jctl_uint i = 0; i < n; ++i)
+	{
+		if(!perm[i])
+			continue;
+		jctl_uring_queue(r, &tail, fn[i], i, O_RDONLY);
+		++m;
+	}
+
+	if(m > 0)
+	{
+		__atomic_store_n(r->sqtail, tail, __ATOMIC_RELEASE);
+		jctl_uring_run(r, m * JCTL_URING_OPS, size, lc, err, perm);
+	}
+}
+
+
+#else /* !defined(JCTL_URING) */
+
+
+jctl_uring *jctl_uring_new (void)
+{
+	return NULL;
+}
+
+
+void jctl_uring_free (jctl_uring *r)
+{
+}
+
+
+void jctl_uring_linecount (jctl_uring *r, char **fn, const jctl_size *size, jctl_uint n, jctl_size *lc, jctl_uint *err)
+{
+	for(jctl_uint i = 0; i < n; ++i)
+		err[i] = 1;
+}
+
+
+#endif /* defined(JCTL_URING) */
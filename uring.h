@@ -0,0 +1,35 @@
+#ifndef JCTL_URING_H
+#define JCTL_URING_H
+
+#include "jctl.h"
+
+
+/*
+ * Files smaller than JCTL_URING_SLOT bytes
+ * are read with a single read into a slot of that size.
+ * At most JCTL_URING_SLOTS files are in flight at once.
+ */
+#define JCTL_URING_SLOT		(64 * 1024)
+#define JCTL_URING_SLOTS	(16)
+
+
+/*
+*
+* io_uring Backend
+*
+* Opens, reads and closes a batch of small files with
+* linked submissions on one ring, instead of three syscalls per file.
+* Only available on Linux, 'jctl_uring_new' returns NULL elsewhere
+* and on kernels without io_uring.
+*
+*/
+typedef struct jctl_uring_s jctl_uring;
+
+
+jctl_uring*	jctl_uring_new			(void);
+void		jctl_uring_free			(jctl_uring *r);
+
+void		jctl_uring_linecount	(jctl_uring *r, char **fn, const jctl_size *size, jctl_uint n, jctl_size *lc, jctl_uint *err);
+
+
+#endif /* JCTL_URING_H */
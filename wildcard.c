@@ -1,323 +1,682 @@
-/*
- * Wildcard matching engine taken from the github repository of PuTTY,
- * a free Windows and Unix Telnet and SSH client.
- * https://github.com/github/putty
- */
-
-/*
- * PuTTY is copyright 1997-2020 Simon Tatham.
- * 
- * Portions copyright Robert de Bath, Joris van Rantwijk, Delian
- * Delchev, Andreas Schultz, Jeroen Massar, Wez Furlong, Nicolas Barry,
- * Justin Bradford, Ben Harris, Malcolm Smith, Ahmad Khalifa, Markus
- * Kuhn, Colin Watson, Christopher Staite, Lorenz Diener, Christian
- * Brabandt, Jeff Smith, Pavel Kryukov, Maxim Kuznetsov, Svyatoslav
- * Kuzmich, Nico Williams, Viktor Dukhovni, Josh Dersch, Lars Brinkhoff,
- * and CORE SDI S.A.
- * 
- * Permission is hereby granted, free of charge, to any person
- * obtaining a copy of this software and associated documentation files
- * (the "Software"), to deal in the Software without restriction,
- * including without limitation the rights to use, copy, modify, merge,
- * publish, distribute, sublicense, and/or sell copies of the Software,
- * and to permit persons to whom the Software is furnished to do so,
- * subject to the following conditions:
- * 
- * The above copyright notice and this permission notice shall be
- * included in all copies or substantial portions of the Software.
- * 
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
- * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
- * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
- * NONINFRINGEMENT.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE
- * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
- * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
- * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
- */
-
-#include <assert.h>
-#include <stdlib.h>
-#include <string.h>
-
-#include "wildcard.h"
-#include "jctl.h"
-
-/*
- * Definition of wildcard syntax:
- *
- *  - * matches any sequence of characters, including zero.
- *  - ? matches exactly one character which can be anything.
- *  - [abc] matches exactly one character which is a, b or c.
- *  - [a-f] matches anything from a through f.
- *  - [^a-f] matches anything _except_ a through f.
- *  - [-_] matches - or _; [^-_] matches anything else. (The - is
- *    non-special if it occurs immediately after the opening
- *    bracket or ^.)
- *  - [a^] matches an a or a ^. (The ^ is non-special if it does
- *    _not_ occur immediately after the opening bracket.)
- *  - \*, \?, \[, \], \\ match the single characters *, ?, [, ], \.
- *  - All other characters are non-special and match themselves.
- */
-
-/*
- * Some notes on differences from POSIX globs (IEEE Std 1003.1, 2003 ed.):
- *  - backslashes act as escapes even within [] bracket expressions
- *  - does not support [!...] for non-matching list (POSIX are weird);
- *    NB POSIX allows [^...] as well via "A bracket expression starting
- *    with an unquoted circumflex character produces unspecified
- *    results". If we wanted to allow [!...] we might want to define
- *    [^!] as having its literal meaning (match '^' or '!').
- *  - none of the scary [[:class:]] stuff, etc
- */
-
-/*
- * The wildcard matching technique we use is very simple and
- * potentially O(N^2) in running time, but I don't anticipate it
- * being that bad in reality (particularly since N will be the size
- * of a filename, which isn't all that much). Perhaps one day, once
- * PuTTY has grown a regexp matcher for some other reason, I might
- * come back and reimplement wildcards by translating them into
- * regexps or directly into NFAs; but for the moment, in the
- * absence of any other need for the NFA->DFA translation engine,
- * anything more than the simplest possible wildcard matcher is
- * vast code-size overkill.
- *
- * Essentially, these wildcards are much simpler than regexps in
- * that they consist of a sequence of rigid fragments (? and [...]
- * can never match more or less than one character) separated by
- * asterisks. It is therefore extremely simple to look at a rigid
- * fragment and determine whether or not it begins at a particular
- * point in the test string; so we can search along the string
- * until we find each fragment, then search for the next. As long
- * as we find each fragment in the _first_ place it occurs, there
- * will never be a danger of having to backpedal and try to find it
- * again somewhere else.
- */
-
-
- enum
- {
-    WC_TRAILINGBACKSLASH = 1,
-    WC_UNCLOSEDCLASS,
-    WC_INVALIDRANGE
-};
-
-
-/*
- * This is the routine that tests a target string to see if an
- * initial substring of it matches a fragment. If successful, it
- * returns 1, and advances both `fragment' and `target' past the
- * fragment and matching substring respectively. If unsuccessful it
- * returns zero. If the wildcard fragment suffers a syntax error,
- * it returns <0 and the precise value indexes into wc_error.
- */
-static int wc_match_fragment(const char **fragment, const char **target,
-                             const char *target_end)
-{
-    const char *f, *t;
-
-    f = *fragment;
-    t = *target;
-    /*
-     * The fragment terminates at either the end of the string, or
-     * the first (unescaped) *.
-     */
-    while (*f && *f != '*' && t < target_end) {
-        /*
-         * Extract one character from t, and one character's worth
-         * of pattern from f, and step along both. Return 0 if they
-         * fail to match.
-         */
-        if (*f == '\\') {
-            /*
-             * Backslash, which means f[1] is to be treated as a
-             * literal character no matter what it is. It may not
-             * be the end of the string.
-             */
-            if (!f[1])
-                return -WC_TRAILINGBACKSLASH;   /* error */
-            if (f[1] != *t)
-                return 0;              /* failed to match */
-            f += 2;
-        } else if (*f == '?') {
-            /*
-             * Question mark matches anything.
-             */
-            f++;
-        } else if (*f == '[') {
-            int invert = 0;
-            int matched = 0;
-            /*
-             * Open bracket introduces a character class.
-             */
-            f++;
-            if (*f == '^') {
-                invert = 1;
-                f++;
-            }
-            while (*f != ']') {
-                if (*f == '\\')
-                    f++;               /* backslashes still work */
-                if (!*f)
-                    return -WC_UNCLOSEDCLASS;   /* error again */
-                if (f[1] == '-') {
-                    int lower, upper, ourchr;
-                    lower = (unsigned char) *f++;
-                    f++;               /* eat the minus */
-                    if (*f == ']')
-                        return -WC_INVALIDRANGE;   /* different error! */
-                    if (*f == '\\')
-                        f++;           /* backslashes _still_ work */
-                    if (!*f)
-                        return -WC_UNCLOSEDCLASS;   /* error again */
-                    upper = (unsigned char) *f++;
-                    ourchr = (unsigned char) *t;
-                    if (lower > upper) {
-                        int t = lower; lower = upper; upper = t;
-                    }
-                    if (ourchr >= lower && ourchr <= upper)
-                        matched = 1;
-                } else {
-                    matched |= (*t == *f++);
-                }
-            }
-            if (invert == matched)
-                return 0;              /* failed to match character class */
-            f++;                       /* eat the ] */
-        } else {
-            /*
-             * Non-special character matches itself.
-             */
-            if (*f != *t)
-                return 0;
-            f++;
-        }
-        /*
-         * Now we've done that, increment t past the character we
-         * matched.
-         */
-        t++;
-    }
-    if (!*f || *f == '*') {
-        /*
-         * We have reached the end of f without finding a mismatch;
-         * so we're done. Update the caller pointers and return 1.
-         */
-        *fragment = f;
-        *target = t;
-        return 1;
-    }
-    /*
-     * Otherwise, we must have reached the end of t before we
-     * reached the end of f; so we've failed. Return 0.
-     */
-    return 0;
-}
-
-/*
- * This is the real wildcard matching routine. It returns 1 for a
- * successful match, 0 for an unsuccessful match, and <0 for a
- * syntax error in the wildcard.
- */
-int wc_match(
-    const char *wildcard, const char *target, size_t target_len)
-{
-    const char *target_end = target + target_len;
-    int ret;
-
-    /*
-     * Every time we see a '*' _followed_ by a fragment, we just
-     * search along the string for a location at which the fragment
-     * matches. The only special case is when we see a fragment
-     * right at the start, in which case we just call the matching
-     * routine once and give up if it fails.
-     */
-    if (*wildcard != '*') {
-        ret = wc_match_fragment(&wildcard, &target, target_end);
-        if (ret <= 0)
-            return ret;                /* pass back failure or error alike */
-    }
-
-    while (*wildcard) {
-        assert(*wildcard == '*');
-        while (*wildcard == '*')
-            wildcard++;
-
-        /*
-         * It's possible we've just hit the end of the wildcard
-         * after seeing a *, in which case there's no need to
-         * bother searching any more because we've won.
-         */
-        if (!*wildcard)
-            return 1;
-
-        /*
-         * Now `wildcard' points at the next fragment. So we
-         * attempt to match it against `target', and if that fails
-         * we increment `target' and try again, and so on. When we
-         * find we're about to try matching against the empty
-         * string, we give up and return 0.
-         */
-        ret = 0;
-        while (*target) {
-            const char *save_w = wildcard, *save_t = target;
-
-            ret = wc_match_fragment(&wildcard, &target, target_end);
-
-            if (ret < 0)
-                return ret;            /* syntax error */
-
-            if (ret > 0 && !*wildcard && target != target_end) {
-                /*
-                 * Final special case - literally.
-                 *
-                 * This situation arises when we are matching a
-                 * _terminal_ fragment of the wildcard (that is,
-                 * there is nothing after it, e.g. "*a"), and it
-                 * has matched _too early_. For example, matching
-                 * "*a" against "parka" will match the "a" fragment
-                 * against the _first_ a, and then (if it weren't
-                 * for this special case) matching would fail
-                 * because we're at the end of the wildcard but not
-                 * at the end of the target string.
-                 *
-                 * In this case what we must do is measure the
-                 * length of the fragment in the target (which is
-                 * why we saved `target'), jump straight to that
-                 * distance from the end of the string using
-                 * strlen, and match the same fragment again there
-                 * (which is why we saved `wildcard'). Then we
-                 * return whatever that operation returns.
-                 */
-                target = target_end - (target - save_t);
-                wildcard = save_w;
-                return wc_match_fragment(&wildcard, &target, target_end);
-            }
-
-            if (ret > 0)
-                break;
-            target++;
-        }
-        if (ret > 0)
-            continue;
-        return 0;
-    }
-
-    /*
-     * If we reach here, it must be because we successfully matched
-     * a fragment and then found ourselves right at the end of the
-     * wildcard. Hence, we return 1 if and only if we are also
-     * right at the end of the target.
-     */
-    return target == target_end;
-}
-
-
-/*
- * Check if the given string 'str' matches the wildcard syntax.
- * Return 1 if it does, otherwise return 0.
- */
-int wc_correct (const char *str)
-{
-    return _jctl_strspn("*^[]", str) > 0;
-}
+/*
+ * Wildcard matching engine taken from the github repository of PuTTY,
+ * a free Windows and Unix Telnet and SSH client.
+ * https://github.com/github/putty
+ */
+
+/*
+ * PuTTY is copyright 1997-2020 Simon Tatham.
+ * 
+ * Portions copyright Robert de Bath, Joris van Rantwijk, Delian
+ * Delchev, Andreas Schultz, Jeroen Massar, Wez Furlong, Nicolas Barry,
+ * Justin Bradford, Ben Harris, Malcolm Smith, Ahmad Khalifa, Markus
+ * Kuhn, Colin Watson, Christopher Staite, Lorenz Diener, Christian
+ * Brabandt, Jeff Smith, Pavel Kryukov, Maxim Kuznetsov, Svyatoslav
+ * Kuzmich, Nico Williams, Viktor Dukhovni, Josh Dersch, Lars Brinkhoff,
+ * and CORE SDI S.A.
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "wildcard.h"
+#include "jctl.h"
+
+/*
+ * Definition of wildcard syntax:
+ *
+ *  - * matches any sequence of characters, including zero.
+ *  - ? matches exactly one character which can be anything.
+ *  - [abc] matches exactly one character which is a, b or c.
+ *  - [a-f] matches anything from a through f.
+ *  - [^a-f] matches anything _except_ a through f.
+ *  - [-_] matches - or _; [^-_] matches anything else. (The - is
+ *    non-special if it occurs immediately after the opening
+ *    bracket or ^.)
+ *  - [a^] matches an a or a ^. (The ^ is non-special if it does
+ *    _not_ occur immediately after the opening bracket.)
+ *  - \*, \?, \[, \], \\ match the single characters *, ?, [, ], \.
+ *  - All other characters are non-special and match themselves.
+ */
+
+/*
+ * Some notes on differences from POSIX globs (IEEE Std 1003.1, 2003 ed.):
+ *  - backslashes act as escapes even within [] bracket expressions
+ *  - does not support [!...] for non-matching list (POSIX are weird);
+ *    NB POSIX allows [^...] as well via "A bracket expression starting
+ *    with an unquoted circumflex character produces unspecified
+ *    results". If we wanted to allow [!...] we might want to define
+ *    [^!] as having its literal meaning (match '^' or '!').
+ *  - none of the scary [[:class:]] stuff, etc
+ */
+
+/*
+ * The wildcard matching technique we use is very simple and
+ * potentially O(N^2) in running time, but I don't anticipate it
+ * being that bad in reality (particularly since N will be the size
+ * of a filename, which isn't all that much). Perhaps one day, once
+ * PuTTY has grown a regexp matcher for some other reason, I might
+ * come back and reimplement wildcards by translating them into
+ * regexps or directly into NFAs; but for the moment, in the
+ * absence of any other need for the NFA->DFA translation engine,
+ * anything more than the simplest possible wildcard matcher is
+ * vast code-size overkill.
+ *
+ * Essentially, these wildcards are much simpler than regexps in
+ * that they consist of a sequence of rigid fragments (? and [...]
+ * can never match more or less than one character) separated by
+ * asterisks. It is therefore extremely simple to look at a rigid
+ * fragment and determine whether or not it begins at a particular
+ * point in the test string; so we can search along the string
+ * until we find each fragment, then search for the next. As long
+ * as we find each fragment in the _first_ place it occurs, there
+ * will never be a danger of having to backpedal and try to find it
+ * again somewhere else.
+ */
+
+
+ enum
+ {
+    WC_TRAILINGBACKSLASH = 1,
+    WC_UNCLOSEDCLASS,
+    WC_INVALIDRANGE
+};
+
+
+/*
+ * This is the routine that tests a target string to see if an
+ * initial substring of it matches a fragment. If successful, it
+ * returns 1, and advances both `fragment' and `target' past the
+ * fragment and matching substring respectively. If unsuccessful it
+ * returns zero. If the wildcard fragment suffers a syntax error,
+ * it returns <0 and the precise value indexes into wc_error.
+ */
+static int wc_match_fragment(const char **fragment, const char **target,
+                             const char *target_end)
+{
+    const char *f, *t;
+
+    f = *fragment;
+    t = *target;
+    /*
+     * The fragment terminates at either the end of the string, or
+     * the first (unescaped) *.
+     */
+    while (*f && *f != '*' && t < target_end) {
+        /*
+         * Extract one character from t, and one character's worth
+         * of pattern from f, and step along both. Return 0 if they
+         * fail to match.
+         */
+        if (*f == '\\') {
+            /*
+             * Backslash, which means f[1] is to be treated as a
+             * literal character no matter what it is. It may not
+             * be the end of the string.
+             */
+            if (!f[1])
+                return -WC_TRAILINGBACKSLASH;   /* error */
+            if (f[1] != *t)
+                return 0;              /* failed to match */
+            f += 2;
+        } else if (*f == '?') {
+            /*
+             * Question mark matches anything.
+             */
+            f++;
+        } else if (*f == '[') {
+            int invert = 0;
+            int matched = 0;
+            /*
+             * Open bracket introduces a character class.
+             */
+            f++;
+            if (*f == '^') {
+                invert = 1;
+                f++;
+            }
+            while (*f != ']') {
+                if (*f == '\\')
+                    f++;               /* backslashes still work */
+                if (!*f)
+                    return -WC_UNCLOSEDCLASS;   /* error again */
+                if (f[1] == '-') {
+                    int lower, upper, ourchr;
+                    lower = (unsigned char) *f++;
+                    f++;               /* eat the minus */
+                    if (*f == ']')
+                        return -WC_INVALIDRANGE;   /* different error! */
+                    if (*f == '\\')
+                        f++;           /* backslashes _still_ work */
+                    if (!*f)
+                        return -WC_UNCLOSEDCLASS;   /* error again */
+                    upper = (unsigned char) *f++;
+                    ourchr = (unsigned char) *t;
+                    if (lower > upper) {
+                        int t = lower; lower = upper; upper = t;
+                    }
+                    if (ourchr >= lower && ourchr <= upper)
+                        matched = 1;
+                } else {
+                    matched |= (*t == *f++);
+                }
+            }
+            if (invert == matched)
+                return 0;              /* failed to match character class */
+            f++;                       /* eat the ] */
+        } else {
+            /*
+             * Non-special character matches itself.
+             */
+            if (*f != *t)
+                return 0;
+            f++;
+        }
+        /*
+         * Now we've done that, increment t past the character we
+         * matched.
+         */
+        t++;
+    }
+    if (!*f || *f == '*') {
+        /*
+         * We have reached the end of f without finding a mismatch;
+         * so we're done. Update the caller pointers and return 1.
+         */
+        *fragment = f;
+        *target = t;
+        return 1;
+    }
+    /*
+     * Otherwise, we must have reached the end of t before we
+     * reached the end of f; so we've failed. Return 0.
+     */
+    return 0;
+}
+
+/*
+ * This is the real wildcard matching routine. It returns 1 for a
+ * successful match, 0 for an unsuccessful match, and <0 for a
+ * syntax error in the wildcard.
+ */
+int wc_match(
+    const char *wildcard, const char *target, size_t target_len)
+{
+    const char *target_end = target + target_len;
+    int ret;
+
+    /*
+     * Every time we see a '*' _followed_ by a fragment, we just
+     * search along the string for a location at which the fragment
+     * matches. The only special case is when we see a fragment
+     * right at the start, in which case we just call the matching
+     * routine once and give up if it fails.
+     */
+    if (*wildcard != '*') {
+        ret = wc_match_fragment(&wildcard, &target, target_end);
+        if (ret <= 0)
+            return ret;                /* pass back failure or error alike */
+    }
+
+    while (*wildcard) {
+        assert(*wildcard == '*');
+        while (*wildcard == '*')
+            wildcard++;
+
+        /*
+         * It's possible we've just hit the end of the wildcard
+         * after seeing a *, in which case there's no need to
+         * bother searching any more because we've won.
+         */
+        if (!*wildcard)
+            return 1;
+
+        /*
+         * Now `wildcard' points at the next fragment. So we
+         * attempt to match it against `target', and if that fails
+         * we increment `target' and try again, and so on. When we
+         * find we're about to try matching against the empty
+         * string, we give up and return 0.
+         */
+        ret = 0;
+        while (*target) {
+            const char *save_w = wildcard, *save_t = target;
+
+            ret = wc_match_fragment(&wildcard, &target, target_end);
+
+            if (ret < 0)
+                return ret;            /* syntax error */
+
+            if (ret > 0 && !*wildcard && target != target_end) {
+                /*
+                 * Final special case - literally.
+                 *
+                 * This situation arises when we are matching a
+                 * _terminal_ fragment of the wildcard (that is,
+                 * there is nothing after it, e.g. "*a"), and it
+                 * has matched _too early_. For example, matching
+                 * "*a" against "parka" will match the "a" fragment
+                 * against the _first_ a, and then (if it weren't
+                 * for this special case) matching would fail
+                 * because we're at the end of the wildcard but not
+                 * at the end of the target string.
+                 *
+                 * In this case what we must do is measure the
+                 * length of the fragment in the target (which is
+                 * why we saved `target'), jump straight to that
+                 * distance from the end of the string using
+                 * strlen, and match the same fragment again there
+                 * (which is why we saved `wildcard'). Then we
+                 * return whatever that operation returns.
+                 */
+                target = target_end - (target - save_t);
+                wildcard = save_w;
+                return wc_match_fragment(&wildcard, &target, target_end);
+            }
+
+            if (ret > 0)
+                break;
+            target++;
+        }
+        if (ret > 0)
+            continue;
+        return 0;
+    }
+
+    /*
+     * If we reach here, it must be because we successfully matched
+     * a fragment and then found ourselves right at the end of the
+     * wildcard. Hence, we return 1 if and only if we are also
+     * right at the end of the target.
+     */
+    return target == target_end;
+}
+
+
+/*
+ * Compiled wildcards.
+ *
+ * 'wc_match' re-parses every character class for every name it is
+ * given. 'wc_compile' parses the wildcard once into a sequence of
+ * positions, one per character to match, each with the set of bytes
+ * it accepts and whether a * precedes it, plus a final position.
+ * The sets of positions reachable after each prefix of a name are
+ * then enumerated into a deterministic automaton, over classes of
+ * bytes that no position tells apart, so that matching a name is a
+ * single table lookup per character.
+ *
+ * A wildcard matches exactly the names 'wc_match' accepts: the
+ * fragments between stars are matched at their leftmost position,
+ * which accepts a name if any placement does. Wildcards with syntax
+ * errors, too many positions or too many states are not compiled,
+ * 'wc_dfa_match' passes them on to 'wc_match'.
+ */
+typedef struct wc_pos_s
+{
+    unsigned char set[32];      /* bytes matched, none for a final position */
+    int loop;                   /* preceded by a *, stays on any byte */
+    int tag;                    /* wildcard index of a final position, else -1 */
+} wc_pos;
+
+#define WC_SET(s, c)    ((s)[(unsigned char)(c) >> 3] |= 1 << ((unsigned char)(c) & 7))
+#define WC_HAS(s, c)    ((s)[(unsigned char)(c) >> 3] & 1 << ((unsigned char)(c) & 7))
+
+/*
+ * Parse 'wildcard' into positions starting at 'pos', following the
+ * syntax rules of 'wc_match_fragment' exactly. Return the number of
+ * positions, -1 if there are more than 'max', or a negative wildcard
+ * error. With 'pos' NULL the syntax is only checked.
+ */
+static int wc_parse(const char *wildcard, wc_pos *pos, int max, int tag)
+{
+    const char *f = wildcard;
+    wc_pos scratch, *p;
+    int n = 0, loop = 0, invert, lower, upper, c, i;
+
+    while (*f) {
+        if (*f == '*') {
+            loop = 1;
+            f++;
+            continue;
+        }
+        if (pos && n + 1 >= max)
+            return -1;
+        p = pos ? pos + n : &scratch;
+        n++;
+        memset(p->set, 0, sizeof(p->set));
+        p->loop = loop;
+        p->tag = -1;
+        loop = 0;
+
+        if (*f == '\\') {
+            if (!f[1])
+                return -WC_TRAILINGBACKSLASH;
+            WC_SET(p->set, f[1]);
+            f += 2;
+        } else if (*f == '?') {
+            memset(p->set, 0xFF, sizeof(p->set));
+            f++;
+        } else if (*f == '[') {
+            f++;
+            invert = 0;
+            if (*f == '^') {
+                invert = 1;
+                f++;
+            }
+            while (*f != ']') {
+                if (*f == '\\')
+                    f++;
+                if (!*f)
+                    return -WC_UNCLOSEDCLASS;
+                if (f[1] == '-') {
+                    lower = (unsigned char)*f++;
+                    f++;
+                    if (*f == ']')
+                        return -WC_INVALIDRANGE;
+                    if (*f == '\\')
+                        f++;
+                    if (!*f)
+                        return -WC_UNCLOSEDCLASS;
+                    upper = (unsigned char)*f++;
+                    if (upper < lower) {
+                        c = lower;
+                        lower = upper;
+                        upper = c;
+                    }
+                    for (c = lower; c <= upper; c++)
+                        WC_SET(p->set, c);
+                } else {
+                    WC_SET(p->set, *f);
+                    f++;
+                }
+            }
+            f++;
+            if (invert)
+                for (i = 0; i < 32; i++)
+                    p->set[i] = ~p->set[i];
+        } else {
+            WC_SET(p->set, *f);
+            f++;
+        }
+    }
+
+    p = pos ? pos + n : &scratch;
+    n++;
+    memset(p->set, 0, sizeof(p->set));
+    p->loop = loop;
+    p->tag = tag;
+    return n;
+}
+
+static size_t wc_state_hash(const unsigned long long *s, int words)
+{
+    unsigned long long h = 0xcbf29ce484222325ULL;
+    int i;
+
+    for (i = 0; i < words; i++)
+        h = (h ^ s[i]) * 0x100000001b3ULL;
+    return (size_t)(h ^ (h >> 29));
+}
+
+/*
+ * Build the automaton of the 'npos' positions 'pos',
+ * where every wildcard starts right after a final position.
+ * Return 0 on success, 1 if it has too many states or memory ran out.
+ */
+static int wc_build(wc_dfa *dfa, const wc_pos *pos, int npos)
+{
+    int words = (npos + 63) / 64;
+    int cap = WC_DFA_MAX_STATES, hcap = 2 * WC_DFA_MAX_STATES;
+    unsigned long long *states, *sig, *next, *s;
+    unsigned short *shrunk;
+    unsigned char rep[256];
+    int *table, i, j, k, c, b;
+    size_t h;
+
+    states = calloc((size_t)cap * words, sizeof(*states));
+    sig = calloc((size_t)256 * words, sizeof(*sig));
+    next = malloc(words * sizeof(*next));
+    table = malloc(hcap * sizeof(*table));
+    dfa->next = malloc((size_t)cap * 256 * sizeof(*dfa->next));
+    dfa->accept = malloc(cap * sizeof(*dfa->accept));
+    if (!states || !sig || !next || !table || !dfa->next || !dfa->accept)
+        goto fail;
+
+    /*
+     * Bytes accepted by the same positions share a class.
+     */
+    for (c = 0; c < 256; c++)
+        for (i = 0; i < npos; i++)
+            if (WC_HAS(pos[i].set, c))
+                sig[c * words + i / 64] |= 1ULL << (i % 64);
+    dfa->nclasses = 0;
+    for (c = 0; c < 256; c++) {
+        for (k = 0; k < dfa->nclasses; k++)
+            if (!memcmp(sig + c * words, sig + rep[k] * words,
+                        words * sizeof(*sig)))
+                break;
+        if (k == dfa->nclasses)
+            rep[dfa->nclasses++] = (unsigned char)c;
+        dfa->classes[c] = (unsigned char)k;
+    }
+
+    /*
+     * State 0 is the empty set, a name reaching it never matches.
+     * State 1 is the start of every wildcard.
+     */
+    for (i = 0; i < hcap; i++)
+        table[i] = -1;
+    for (i = 0; i < npos; i++)
+        if (i == 0 || pos[i - 1].tag >= 0)
+            states[words + i / 64] |= 1ULL << (i % 64);
+    dfa->nstates = 2;
+    for (i = 0; i < 2; i++) {
+        h = wc_state_hash(states + i * words, words) % hcap;
+        while (table[h] >= 0)
+            h = (h + 1) % hcap;
+        table[h] = i;
+    }
+
+    for (i = 0; i < dfa->nstates; i++) {
+        s = states + (size_t)i * words;
+        dfa->accept[i] = -1;
+        for (j = 0; j < npos; j++)
+            if ((s[j / 64] >> (j % 64) & 1) && pos[j].tag > dfa->accept[i])
+                dfa->accept[i] = (short)pos[j].tag;
+
+        for (k = 0; k < dfa->nclasses; k++) {
+            memset(next, 0, words * sizeof(*next));
+            for (j = 0; j < npos; j++) {
+                if (!(s[j / 64] >> (j % 64) & 1))
+                    continue;
+                if (pos[j].loop)
+                    next[j / 64] |= 1ULL << (j % 64);
+                if (pos[j].tag < 0 && WC_HAS(pos[j].set, rep[k]))
+                    next[(j + 1) / 64] |= 1ULL << ((j + 1) % 64);
+            }
+
+            h = wc_state_hash(next, words) % hcap;
+            while ((b = table[h]) >= 0 &&
+                   memcmp(states + (size_t)b * words, next,
+                          words * sizeof(*next)))
+                h = (h + 1) % hcap;
+            if (b < 0) {
+                if (dfa->nstates == cap)
+                    goto fail;
+                b = dfa->nstates++;
+                memcpy(states + (size_t)b * words, next,
+                       words * sizeof(*next));
+                table[h] = b;
+            }
+            dfa->next[(size_t)i * dfa->nclasses + k] = (unsigned short)b;
+        }
+    }
+
+    free(states);
+    free(sig);
+    free(next);
+    free(table);
+    shrunk = realloc(dfa->next, (size_t)dfa->nstates * dfa->nclasses *
+                     sizeof(*dfa->next));
+    if (shrunk)
+        dfa->next = shrunk;
+    return 0;
+
+  fail:
+    free(states);
+    free(sig);
+    free(next);
+    free(table);
+    free(dfa->next);
+    free(dfa->accept);
+    dfa->next = NULL;
+    dfa->accept = NULL;
+    dfa->nstates = 0;
+    return 1;
+}
+
+/*
+ * Compile the 'n' wildcards 'wildcards' into one automaton telling
+ * the highest of them that matches a target, see 'wc_dfa_find'.
+ * The wildcards must outlive 'dfa', they are matched one by one if
+ * they cannot be compiled together. Return 0 on success, 1 if memory
+ * ran out.
+ */
+int wc_compile_set(wc_dfa *dfa, const char **wildcards, int n)
+{
+    wc_pos *pos;
+    int npos = 0, i, r;
+
+    memset(dfa, 0, sizeof(*dfa));
+    dfa->wildcards = malloc(n * sizeof(*dfa->wildcards));
+    if (!dfa->wildcards)
+        return 1;
+    memcpy(dfa->wildcards, wildcards, n * sizeof(*wildcards));
+    dfa->n = n;
+
+    pos = malloc(WC_DFA_MAX_POSITIONS * sizeof(*pos));
+    if (!pos)
+        return 0;
+    for (i = 0; i < n; i++) {
+        r = wc_parse(wildcards[i], pos + npos,
+                     WC_DFA_MAX_POSITIONS - npos, i);
+        if (r < 0)
+            break;
+        npos += r;
+    }
+    if (i == n)
+        wc_build(dfa, pos, npos);
+    free(pos);
+    return 0;
+}
+
+/*
+ * Compile 'wildcard' for matching with 'wc_dfa_match'.
+ * 'wildcard' must outlive 'dfa'. Return 0 on success,
+ * 1 if memory ran out.
+ */
+int wc_compile(wc_dfa *dfa, const char *wildcard)
+{
+    return wc_compile_set(dfa, &wildcard, 1);
+}
+
+/*
+ * Match the target against a compiled wildcard,
+ * with the same results as 'wc_match'.
+ */
+int wc_dfa_match(const wc_dfa *dfa, const char *target, size_t target_len)
+{
+    const unsigned char *t = (const unsigned char *)target;
+    const unsigned char *end = t + target_len;
+    const unsigned short *next = dfa->next;
+    int s = 1, n = dfa->nclasses;
+
+    if (!dfa->nstates)
+        return wc_match(dfa->wildcards[0], target, target_len);
+
+    while (t < end) {
+        s = next[s * n + dfa->classes[*t++]];
+        if (!s)
+            return 0;
+    }
+    return dfa->accept[s] >= 0;
+}
+
+/*
+ * Return the index of the highest wildcard of the set 'dfa' matching
+ * the target, or -1 if none does. Wildcards with syntax errors never
+ * match.
+ */
+int wc_dfa_find(const wc_dfa *dfa, const char *target, size_t target_len)
+{
+    const unsigned char *t = (const unsigned char *)target;
+    const unsigned char *end = t + target_len;
+    const unsigned short *next = dfa->next;
+    int s = 1, n = dfa->nclasses, i;
+
+    if (!dfa->nstates) {
+        for (i = dfa->n - 1; i >= 0; i--)
+            if (wc_match(dfa->wildcards[i], target, target_len) > 0)
+                return i;
+        return -1;
+    }
+
+    while (t < end) {
+        s = next[s * n + dfa->classes[*t++]];
+        if (!s)
+            return -1;
+    }
+    return dfa->accept[s];
+}
+
+/*
+ * Check the syntax of 'wildcard' as a whole, which 'wc_match' only
+ * does as far as it gets. Return 0 if it is correct, otherwise a
+ * negative wildcard error.
+ */
+int wc_check(const char *wildcard)
+{
+    int r = wc_parse(wildcard, NULL, 0, 0);
+    return r < 0 ? r : 0;
+}
+
+/*
+ * Free a compiled wildcard.
+ */
+void wc_free(wc_dfa *dfa)
+{
+    free(dfa->wildcards);
+    free(dfa->next);
+    free(dfa->accept);
+    memset(dfa, 0, sizeof(*dfa));
+}
+
+
+/*
+ * Check if the given string 'str' contains wildcard characters.
+ * Return 1 if it does, otherwise return 0.
+ */
+int wc_correct (const char *str)
+{
+    return _jctl_strpbrk(str, "*?[") != NULL;
+}
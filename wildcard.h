@@ -1,48 +1,84 @@
-/*
- * Wildcard matching engine taken from the github repository of PuTTY,
- * a free Windows and Unix Telnet and SSH client.
- * https://github.com/github/putty
- */
-
-/*
- * PuTTY is copyright 1997-2020 Simon Tatham.
- * 
- * Portions copyright Robert de Bath, Joris van Rantwijk, Delian
- * Delchev, Andreas Schultz, Jeroen Massar, Wez Furlong, Nicolas Barry,
- * Justin Bradford, Ben Harris, Malcolm Smith, Ahmad Khalifa, Markus
- * Kuhn, Colin Watson, Christopher Staite, Lorenz Diener, Christian
- * Brabandt, Jeff Smith, Pavel Kryukov, Maxim Kuznetsov, Svyatoslav
- * Kuzmich, Nico Williams, Viktor Dukhovni, Josh Dersch, Lars Brinkhoff,
- * and CORE SDI S.A.
- * 
- * Permission is hereby granted, free of charge, to any person
- * obtaining a copy of this software and associated documentation files
- * (the "Software"), to deal in the Software without restriction,
- * including without limitation the rights to use, copy, modify, merge,
- * publish, distribute, sublicense, and/or sell copies of the Software,
- * and to permit persons to whom the Software is furnished to do so,
- * subject to the following conditions:
- * 
- * The above copyright notice and this permission notice shall be
- * included in all copies or substantial portions of the Software.
- * 
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
- * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
- * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
- * NONINFRINGEMENT.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE
- * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
- * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
- * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
- */
-
-#ifndef JCTL_WILDCARD_H
-#define JCTL_WILDCARD_H
-
-#include <stdlib.h>
-
-
-int wc_match	(const char *wildcard, const char *target, size_t target_len);
-int wc_correct	(const char *wildcard);
-
-
-#endif /* JCTL_WILDCARD_H */
+/*
+ * Wildcard matching engine taken from the github repository of PuTTY,
+ * a free Windows and Unix Telnet and SSH client.
+ * https://github.com/github/putty
+ */
+
+/*
+ * PuTTY is copyright 1997-2020 Simon Tatham.
+ * 
+ * Portions copyright Robert de Bath, Joris van Rantwijk, Delian
+ * Delchev, Andreas Schultz, Jeroen Massar, Wez Furlong, Nicolas Barry,
+ * Justin Bradford, Ben Harris, Malcolm Smith, Ahmad Khalifa, Markus
+ * Kuhn, Colin Watson, Christopher Staite, Lorenz Diener, Christian
+ * Brabandt, Jeff Smith, Pavel Kryukov, Maxim Kuznetsov, Svyatoslav
+ * Kuzmich, Nico Williams, Viktor Dukhovni, Josh Dersch, Lars Brinkhoff,
+ * and CORE SDI S.A.
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef JCTL_WILDCARD_H
+#define JCTL_WILDCARD_H
+
+#include <stdlib.h>
+
+
+/*
+ * Limits of a compiled wildcard,
+ * longer or more complex wildcards are matched by 'wc_match'.
+ */
+#define WC_DFA_MAX_POSITIONS	(512)
+#define WC_DFA_MAX_STATES		(1024)
+
+
+/*
+*
+* Compiled Wildcard
+*
+* Deterministic automaton matching a name in a single pass,
+* one table lookup per character.
+*
+*/
+typedef struct wc_dfa_s
+{
+	int n;							/* wildcard count */
+	const char **wildcards;			/* wildcards, matched directly if there is no automaton */
+	int nstates;					/* state count, 0 if there is no automaton */
+	int nclasses;					/* byte class count */
+	unsigned char classes[256];		/* byte equivalence class of every byte */
+	unsigned short *next;			/* transitions, 'nstates' rows of 'nclasses' */
+	short *accept;					/* highest wildcard matched in a state, -1 if none */
+} wc_dfa;
+
+
+int wc_match		(const char *wildcard, const char *target, size_t target_len);
+int wc_correct		(const char *wildcard);
+
+int wc_check		(const char *wildcard);
+
+int wc_compile		(wc_dfa *dfa, const char *wildcard);
+int wc_compile_set	(wc_dfa *dfa, const char **wildcards, int n);
+int wc_dfa_match	(const wc_dfa *dfa, const char *target, size_t target_len);
+int wc_dfa_find		(const wc_dfa *dfa, const char *target, size_t target_len);
+void wc_free		(wc_dfa *dfa);
+
+
+#endif /* JCTL_WILDCARD_H */